@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "basemodel.h"
+
+#include <QtTest>
+
+#include <random>
+
+/**
+ * Updating a 10k row BaseModel with 1% churn: half of it removed rows,
+ * half inserted ones, plus a few moved and changed rows. Compares the
+ * reset of the old assignment with the diff by value and by key.
+ */
+struct Entry
+{
+    int id;
+    QString name;
+
+    bool operator==(const Entry &other) const { return id == other.id && name == other.name; }
+};
+
+Q_DECLARE_METATYPE(Entry)
+
+static int entryKey(const Entry &entry)
+{
+    return entry.id;
+}
+
+class SignalCounter : public QObject
+{
+public:
+    explicit SignalCounter(QAbstractItemModel *model)
+    {
+        connect(model, &QAbstractItemModel::rowsInserted, this, [this] { ++inserts; });
+        connect(model, &QAbstractItemModel::rowsRemoved, this, [this] { ++removes; });
+        connect(model, &QAbstractItemModel::rowsMoved, this, [this] { ++moves; });
+        connect(model, &QAbstractItemModel::dataChanged, this, [this] { ++changes; });
+        connect(model, &QAbstractItemModel::modelReset, this, [this] { ++resets; });
+    }
+
+    int inserts = 0;
+    int removes = 0;
+    int moves = 0;
+    int changes = 0;
+    int resets = 0;
+};
+
+class BenchBaseModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void assign_data();
+    void assign();
+
+private:
+    QList<Entry> m_before;
+    QList<Entry> m_after;
+};
+
+void BenchBaseModel::initTestCase()
+{
+    const int count = 10000;
+    const int churn = count / 100;
+
+    for (int i = 0; i < count; ++i)
+        m_before.append({ i, QStringLiteral("Application %1").arg(i) });
+
+    // Fixed seed, the same edit script on every run.
+    std::mt19937 random(42);
+    auto row = [&] { return int(random() % unsigned(m_after.size())); };
+    m_after = m_before;
+    int nextId = count;
+
+    for (int i = 0; i < churn / 2; ++i) {
+        m_after.removeAt(row());
+        m_after.insert(row(), { nextId, QStringLiteral("Application %1").arg(nextId) });
+        ++nextId;
+    }
+
+    for (int i = 0; i < churn / 10; ++i) {
+        const int from = row();
+        m_after.move(from, row());
+    }
+
+    for (int i = 0; i < churn / 10; ++i)
+        m_after[row()].name += QStringLiteral(" (updated)");
+}
+
+void BenchBaseModel::assign_data()
+{
+    QTest::addColumn<int>("mode");
+
+    QTest::newRow("reset") << 0;
+    QTest::newRow("diff by value") << 1;
+    QTest::newRow("diff by key") << 2;
+}
+
+void BenchBaseModel::assign()
+{
+    QFETCH(int, mode);
+
+    BaseModel<Entry> model;
+    QList<Entry> initial = m_before;
+    model.swap(initial);
+
+    SignalCounter counter(&model);
+    bool forward = true;
+    int runs = 0;
+
+    // Alternates between both lists, so every run applies the same churn.
+    QBENCHMARK {
+        const QList<Entry> &target = forward ? m_after : m_before;
+
+        if (mode == 0) {
+            QList<Entry> copy = target;
+            model.swap(copy);
+        } else if (mode == 1) {
+            model.setList(target);
+        } else {
+            model.setList(target, entryKey);
+        }
+
+        forward = !forward;
+        ++runs;
+    }
+
+    QVERIFY(model.ref() == (forward ? m_before : m_after));
+
+    qDebug("per update: %.1f inserts, %.1f removes, %.1f moves, %.1f changes, %.1f resets",
+           qreal(counter.inserts) / runs, qreal(counter.removes) / runs, qreal(counter.moves) / runs,
+           qreal(counter.changes) / runs, qreal(counter.resets) / runs);
+}
+
+QTEST_GUILESS_MAIN(BenchBaseModel)
+
+#include "bench_basemodel.moc"
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "basemodel.h"
+
+#include <QtTest>
+#include <QQmlComponent>
+#include <QQmlContext>
+#include <QQmlEngine>
+
+/**
+ * What a delegate pays to read three fields of a row: boxed, where every
+ * binding copies the whole row into a QVariant through modelData, against
+ * one role per field declared with BASEMODEL_FIELDS.
+ */
+struct Row
+{
+    Q_GADGET
+    Q_PROPERTY(QString name MEMBER name)
+    Q_PROPERTY(QString iconName MEMBER iconName)
+    Q_PROPERTY(QString comment MEMBER comment)
+
+public:
+    QString id;
+    QString name;
+    QString iconName;
+    QString comment;
+    QStringList args;
+};
+
+Q_DECLARE_METATYPE(Row)
+
+BASEMODEL_FIELDS(Row,
+    BASEMODEL_MEMBER(Row, name),
+    BASEMODEL_MEMBER(Row, iconName),
+    BASEMODEL_MEMBER(Row, comment))
+
+static const int RowCount = 1000;
+
+class BenchBaseModelRoles : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void read_data();
+    void read();
+    void delegates_data();
+    void delegates();
+
+private:
+    BaseModel<Row> m_model;
+};
+
+void BenchBaseModelRoles::initTestCase()
+{
+    QList<Row> rows;
+
+    for (int i = 0; i < RowCount; ++i) {
+        Row row;
+        row.id = QStringLiteral("/usr/share/applications/app-%1.desktop").arg(i);
+        row.name = QStringLiteral("Application %1").arg(i);
+        row.iconName = QStringLiteral("app-%1").arg(i % 64);
+        row.comment = QStringLiteral("Does something useful");
+        row.args = QStringList() << QStringLiteral("app-%1").arg(i) << QStringLiteral("%U");
+        rows.append(row);
+    }
+
+    m_model.setList(rows);
+
+    QCOMPARE(m_model.roleNames().value(BaseModel<Row>::FirstFieldRole), QByteArray("name"));
+}
+
+void BenchBaseModelRoles::read_data()
+{
+    QTest::addColumn<bool>("fields");
+
+    QTest::newRow("modelData") << false;
+    QTest::newRow("field roles") << true;
+}
+
+void BenchBaseModelRoles::read()
+{
+    QFETCH(bool, fields);
+    int length = 0;
+
+    // Each binding evaluates on its own, so the boxed row is fetched once per field.
+    QBENCHMARK {
+        for (int i = 0; i < m_model.rowCount(); ++i) {
+            const QModelIndex index = m_model.index(i, 0);
+
+            if (fields) {
+                for (int role = BaseModel<Row>::FirstFieldRole; role < BaseModel<Row>::FirstFieldRole + 3; ++role)
+                    length += m_model.data(index, role).toString().size();
+            } else {
+                length += m_model.data(index, BaseModel<Row>::ModelDataRole).value<Row>().name.size();
+                length += m_model.data(index, BaseModel<Row>::ModelDataRole).value<Row>().iconName.size();
+                length += m_model.data(index, BaseModel<Row>::ModelDataRole).value<Row>().comment.size();
+            }
+        }
+    }
+
+    QVERIFY(length > 0);
+}
+
+void BenchBaseModelRoles::delegates_data()
+{
+    QTest::addColumn<QByteArray>("prefix");
+
+    QTest::newRow("modelData") << QByteArray("modelData");
+    QTest::newRow("field roles") << QByteArray("model");
+}
+
+void BenchBaseModelRoles::delegates()
+{
+    QFETCH(QByteArray, prefix);
+
+    QQmlEngine engine;
+    engine.rootContext()->setContextProperty("rowModel", &m_model);
+
+    QQmlComponent component(&engine);
+    component.setData("import QtQuick 2.12\n"
+                      "Item {\n"
+                      "    Repeater {\n"
+                      "        model: rowModel\n"
+                      "        delegate: Item {\n"
+                      "            property string name: " + prefix + ".name\n"
+                      "            property string iconName: " + prefix + ".iconName\n"
+                      "            property string comment: " + prefix + ".comment\n"
+                      "        }\n"
+                      "    }\n"
+                      "}\n", QUrl());
+    QVERIFY2(component.isReady(), qPrintable(component.errorString()));
+
+    // Creates and binds one delegate per row.
+    QBENCHMARK {
+        QScopedPointer<QObject> root(component.create());
+        QVERIFY(root);
+    }
+}
+
+QTEST_MAIN(BenchBaseModelRoles)
+
+#include "bench_basemodelroles.moc"
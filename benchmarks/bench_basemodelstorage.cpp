@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "basemodel.h"
+#include "appitem.h"
+
+#include <QtTest>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * QList against BaseModelVector storage for BaseModel<AppItem> with 10k
+ * rows: building row by row, range insertion, removal and moves, and a
+ * scan over all rows.
+ *
+ * Next to the time, every benchmark prints the operator new allocations
+ * and the last level cache misses per run. QString data comes from
+ * malloc() and is the same for both storages, so it is not counted.
+ * Cache misses need perf_event_open(), see
+ * /proc/sys/kernel/perf_event_paranoid when they show as unavailable.
+ */
+
+static std::atomic<quint64> s_allocations(0);
+
+void *operator new(std::size_t size)
+{
+    ++s_allocations;
+
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+class CacheMissCounter
+{
+public:
+    CacheMissCounter()
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        m_fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~CacheMissCounter()
+    {
+        if (m_fd >= 0)
+            close(m_fd);
+    }
+
+    bool isValid() const { return m_fd >= 0; }
+
+    void start()
+    {
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    quint64 stop()
+    {
+        quint64 value = 0;
+
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(m_fd, &value, sizeof(value)) != sizeof(value))
+                value = 0;
+        }
+
+        return value;
+    }
+
+private:
+    int m_fd;
+};
+
+// Accumulates the counters of one benchmark over all its runs.
+struct Counters
+{
+    CacheMissCounter cacheMisses;
+    quint64 allocations = 0;
+    quint64 misses = 0;
+    int runs = 0;
+
+    void report() const
+    {
+        if (!runs)
+            return;
+
+        if (cacheMisses.isValid())
+            qDebug("per run: %llu allocations, %llu cache misses",
+                   allocations / runs, misses / runs);
+        else
+            qDebug("per run: %llu allocations, cache misses unavailable",
+                   allocations / runs);
+    }
+};
+
+class Probe
+{
+public:
+    explicit Probe(Counters &counters)
+        : m_counters(counters)
+        , m_allocations(s_allocations.load())
+    {
+        m_counters.cacheMisses.start();
+    }
+
+    ~Probe()
+    {
+        m_counters.misses += m_counters.cacheMisses.stop();
+        m_counters.allocations += s_allocations.load() - m_allocations;
+        ++m_counters.runs;
+    }
+
+private:
+    Counters &m_counters;
+    quint64 m_allocations;
+};
+
+typedef BaseModel<AppItem> ListModel;
+typedef BaseModel<AppItem, BaseModelVector<AppItem> > VectorModel;
+
+static const int RowCount = 10000;
+static const int RangeCount = 100;
+
+static AppItem makeItem(int i)
+{
+    AppItem item;
+    item.id = QStringLiteral("/usr/share/applications/app-%1.desktop").arg(i);
+    item.name = QStringLiteral("Application %1").arg(i);
+    item.genericName = QStringLiteral("Generic application");
+    item.comment = QStringLiteral("Does something useful");
+    item.iconName = QStringLiteral("app-%1").arg(i % 64);
+    item.exec = ExecTemplate::fromArguments(QStringList() << QStringLiteral("app-%1").arg(i));
+    return item;
+}
+
+template <typename Model>
+static typename Model::StorageType makeRows(int first, int count)
+{
+    typename Model::StorageType rows;
+    for (int i = first; i < first + count; ++i)
+        rows.append(makeItem(i));
+    return rows;
+}
+
+template <typename Model>
+static void benchAppend()
+{
+    const typename Model::StorageType rows = makeRows<Model>(0, RowCount);
+    Counters counters;
+
+    QBENCHMARK {
+        Probe probe(counters);
+        Model model;
+        for (int i = 0; i < rows.count(); ++i)
+            model.append(rows.at(i));
+    }
+
+    counters.report();
+}
+
+template <typename Model>
+static void benchInsertRange()
+{
+    Model model;
+    model.insert(0, makeRows<Model>(0, RowCount));
+    const typename Model::StorageType rows = makeRows<Model>(RowCount, RangeCount);
+    Counters counters;
+
+    QBENCHMARK {
+        Probe probe(counters);
+        model.insert(RowCount / 2, rows);
+        model.remove(RowCount / 2, RangeCount);
+    }
+
+    counters.report();
+}
+
+template <typename Model>
+static void benchMoveRange()
+{
+    Model model;
+    model.insert(0, makeRows<Model>(0, RowCount));
+    Counters counters;
+
+    QBENCHMARK {
+        Probe probe(counters);
+        model.move(RangeCount, RangeCount, RowCount / 2);
+        model.move(RowCount / 2, RangeCount, RangeCount);
+    }
+
+    counters.report();
+}
+
+template <typename Model>
+static void benchScan()
+{
+    Model model;
+    model.insert(0, makeRows<Model>(0, RowCount));
+    Counters counters;
+    qint64 length = 0;
+
+    QBENCHMARK {
+        Probe probe(counters);
+        for (int i = 0; i < model.rowCount(); ++i)
+            length += model.at(i).name.size();
+    }
+
+    QVERIFY(length > 0);
+    counters.report();
+}
+
+class BenchBaseModelStorage : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void append_data() { addStorageRows(); }
+    void append();
+    void insertRange_data() { addStorageRows(); }
+    void insertRange();
+    void moveRange_data() { addStorageRows(); }
+    void moveRange();
+    void scan_data() { addStorageRows(); }
+    void scan();
+
+private:
+    void addStorageRows();
+};
+
+void BenchBaseModelStorage::addStorageRows()
+{
+    QTest::addColumn<bool>("contiguous");
+
+    QTest::newRow("QList") << false;
+    QTest::newRow("BaseModelVector") << true;
+}
+
+void BenchBaseModelStorage::append()
+{
+    QFETCH(bool, contiguous);
+    contiguous ? benchAppend<VectorModel>() : benchAppend<ListModel>();
+}
+
+void BenchBaseModelStorage::insertRange()
+{
+    QFETCH(bool, contiguous);
+    contiguous ? benchInsertRange<VectorModel>() : benchInsertRange<ListModel>();
+}
+
+void BenchBaseModelStorage::moveRange()
+{
+    QFETCH(bool, contiguous);
+    contiguous ? benchMoveRange<VectorModel>() : benchMoveRange<ListModel>();
+}
+
+void BenchBaseModelStorage::scan()
+{
+    QFETCH(bool, contiguous);
+    contiguous ? benchScan<VectorModel>() : benchScan<ListModel>();
+}
+
+QTEST_GUILESS_MAIN(BenchBaseModelStorage)
+
+#include "bench_basemodelstorage.moc"
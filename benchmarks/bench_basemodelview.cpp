@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "basemodelview.h"
+
+#include <QSortFilterProxyModel>
+#include <QtTest>
+
+#include <random>
+
+/**
+ * A 10k row BaseModel sorted by name and filtered by a search text,
+ * through QSortFilterProxyModel and through BaseModelView. Measures a
+ * single row inserted and removed again, and a search text that changes.
+ */
+struct Entry
+{
+    int id;
+    QString name;
+
+    bool operator==(const Entry &other) const { return id == other.id && name == other.name; }
+};
+
+Q_DECLARE_METATYPE(Entry)
+
+struct ByName
+{
+    bool operator()(const Entry &a, const Entry &b) const { return a.name < b.name; }
+};
+
+struct NameContains
+{
+    QString text;
+    bool operator()(const Entry &entry) const { return entry.name.contains(text, Qt::CaseInsensitive); }
+};
+
+typedef BaseModelView<Entry, NameContains, ByName> EntryView;
+
+class EntryProxy : public QSortFilterProxyModel
+{
+public:
+    explicit EntryProxy(BaseModel<Entry> *model)
+        : m_model(model)
+    {
+        setDynamicSortFilter(true);
+        setSourceModel(model);
+        sort(0);
+    }
+
+    void setText(const QString &text)
+    {
+        m_filter.text = text;
+        invalidateFilter();
+    }
+
+protected:
+    bool filterAcceptsRow(int row, const QModelIndex &) const override
+    {
+        return m_filter(m_model->at(row));
+    }
+
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override
+    {
+        return ByName()(m_model->at(left.row()), m_model->at(right.row()));
+    }
+
+private:
+    BaseModel<Entry> *m_model;
+    NameContains m_filter;
+};
+
+class SignalCounter : public QObject
+{
+public:
+    explicit SignalCounter(QAbstractItemModel *model)
+    {
+        connect(model, &QAbstractItemModel::rowsInserted, this, [this] { ++count; });
+        connect(model, &QAbstractItemModel::rowsRemoved, this, [this] { ++count; });
+        connect(model, &QAbstractItemModel::rowsMoved, this, [this] { ++count; });
+        connect(model, &QAbstractItemModel::dataChanged, this, [this] { ++count; });
+        connect(model, &QAbstractItemModel::layoutChanged, this, [this] { ++count; });
+        connect(model, &QAbstractItemModel::modelReset, this, [this] { ++count; });
+    }
+
+    int count = 0;
+};
+
+class BenchBaseModelView : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void insertRow_data();
+    void insertRow();
+
+    void search_data();
+    void search();
+
+private:
+    QList<Entry> m_entries;
+};
+
+static const int s_count = 10000;
+
+void BenchBaseModelView::initTestCase()
+{
+    std::mt19937 random(42);
+
+    for (int i = 0; i < s_count; ++i)
+        m_entries.append({ i, QStringLiteral("Application %1").arg(random() % 100000) });
+}
+
+void BenchBaseModelView::insertRow_data()
+{
+    QTest::addColumn<bool>("proxy");
+
+    QTest::newRow("QSortFilterProxyModel") << true;
+    QTest::newRow("BaseModelView") << false;
+}
+
+void BenchBaseModelView::insertRow()
+{
+    QFETCH(bool, proxy);
+
+    BaseModel<Entry> model;
+    QList<Entry> initial = m_entries;
+    model.swap(initial);
+
+    QScopedPointer<QAbstractItemModel> view;
+    if (proxy)
+        view.reset(new EntryProxy(&model));
+    else
+        view.reset(new EntryView(&model));
+
+    SignalCounter counter(view.data());
+    const Entry entry = { s_count, QStringLiteral("Application 50000") };
+    int runs = 0;
+
+    QBENCHMARK {
+        model.insert(s_count / 2, entry);
+        model.removeAt(s_count / 2);
+        ++runs;
+    }
+
+    QCOMPARE(view->rowCount(), s_count);
+    qDebug("per row: %.1f signals", qreal(counter.count) / runs);
+}
+
+void BenchBaseModelView::search_data()
+{
+    QTest::addColumn<bool>("proxy");
+
+    QTest::newRow("QSortFilterProxyModel") << true;
+    QTest::newRow("BaseModelView") << false;
+}
+
+void BenchBaseModelView::search()
+{
+    QFETCH(bool, proxy);
+
+    BaseModel<Entry> model;
+    QList<Entry> initial = m_entries;
+    model.swap(initial);
+
+    EntryProxy proxyModel(&model);
+    EntryView view(&model);
+    QAbstractItemModel *target = proxy ? static_cast<QAbstractItemModel *>(&proxyModel) : &view;
+
+    // Typing "12" and deleting it again.
+    const QStringList texts = { QStringLiteral("1"), QStringLiteral("12"), QStringLiteral("1"), QString() };
+    SignalCounter counter(target);
+    int runs = 0;
+
+    QBENCHMARK {
+        for (const QString &text : texts) {
+            if (proxy)
+                proxyModel.setText(text);
+            else
+                view.setPredicate(NameContains { text });
+        }
+        ++runs;
+    }
+
+    QCOMPARE(target->rowCount(), s_count);
+    qDebug("per keystroke: %.1f signals", qreal(counter.count) / (runs * texts.size()));
+}
+
+QTEST_GUILESS_MAIN(BenchBaseModelView)
+
+#include "bench_basemodelview.moc"
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "exectemplate.h"
+
+#include <QRegularExpression>
+#include <QtTest>
+
+/**
+ * Turning Exec= into argv: the regex passes and split(" ") that
+ * LauncherModel used before, against ExecTemplate::parse(). expand()
+ * is measured on its own, it runs on every launch.
+ */
+static QStringList regexArguments(QString exec)
+{
+    exec.remove(QRegularExpression("%."));
+    exec.remove(QRegularExpression("^\""));
+    exec = exec.replace("\"", "");
+    exec = exec.simplified();
+    return exec.split(" ");
+}
+
+class BenchExecTemplate : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+
+    void expand_data();
+    void expand();
+};
+
+static const char *const s_execs[][2] = {
+    { "plain", "gnome-calculator" },
+    { "field code", "firefox %u" },
+    { "options", "code --unity-launch --new-window %F" },
+    { "quoted", "\"/opt/My App/bin/app\" --name=%c %i %U" },
+    { "shell", "sh -c \"echo \\\\\"$HOME\\\\\" && exec app %f\"" },
+};
+
+void BenchExecTemplate::parse_data()
+{
+    QTest::addColumn<QString>("exec");
+    QTest::addColumn<bool>("regex");
+
+    for (const auto &exec : s_execs) {
+        QTest::newRow(qPrintable(QStringLiteral("%1/regex").arg(exec[0]))) << QString(exec[1]) << true;
+        QTest::newRow(qPrintable(QStringLiteral("%1/tokenizer").arg(exec[0]))) << QString(exec[1]) << false;
+    }
+}
+
+void BenchExecTemplate::parse()
+{
+    QFETCH(QString, exec);
+    QFETCH(bool, regex);
+
+    if (regex) {
+        QBENCHMARK {
+            regexArguments(exec);
+        }
+    } else {
+        QBENCHMARK {
+            ExecTemplate::parse(exec);
+        }
+    }
+}
+
+void BenchExecTemplate::expand_data()
+{
+    QTest::addColumn<QString>("exec");
+
+    for (const auto &exec : s_execs)
+        QTest::newRow(exec[0]) << QString(exec[1]);
+}
+
+void BenchExecTemplate::expand()
+{
+    QFETCH(QString, exec);
+
+    const ExecTemplate execTemplate = ExecTemplate::parse(exec);
+    QVERIFY(!execTemplate.isEmpty());
+
+    const QStringList urls = { QStringLiteral("file:///home/user/Documents/report.odt") };
+    const QString iconName = QStringLiteral("app");
+    const QString name = QStringLiteral("My App");
+    const QString desktopFile = QStringLiteral("/usr/share/applications/app.desktop");
+
+    QBENCHMARK {
+        execTemplate.expand(urls, iconName, name, desktopFile);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchExecTemplate)
+
+#include "bench_exectemplate.moc"
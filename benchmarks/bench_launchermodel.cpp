@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "corpus.h"
+#include "desktopproperties.h"
+#include "launchermodel.h"
+#include "pagemodel.h"
+#include "appitem.h"
+
+#include <QtTest>
+#include <QSettings>
+#include <QTemporaryDir>
+
+/**
+ * Hot paths of the app list: parsing desktop files, building the model,
+ * reacting to one changed file, searching, paging and saving.
+ *
+ * Every benchmark runs against 100, 1k and 10k generated entries. The
+ * settings are redirected to a temporary directory, so the real app list
+ * is never touched.
+ */
+class BenchLauncherModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void parse_data();
+    void parse();
+    void fullRefresh_data();
+    void fullRefresh();
+    void incrementalChange_data();
+    void incrementalChange();
+    void searchPerKeystroke_data();
+    void searchPerKeystroke();
+    void filteredSearch_data();
+    void filteredSearch();
+    void paging_data();
+    void paging();
+    void persistence_data();
+    void persistence();
+
+private:
+    void addCorpusRows();
+    QString corpusPath(int count) const;
+    void clearAppList();
+    LauncherModel *loadModel(int count);
+
+private:
+    QTemporaryDir m_configDir;
+    QTemporaryDir m_corpusDir;
+    QHash<int, QStringList> m_files;
+};
+
+void BenchLauncherModel::initTestCase()
+{
+    QVERIFY(m_configDir.isValid());
+    QVERIFY(m_corpusDir.isValid());
+
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, m_configDir.path());
+
+    for (int count : { 100, 1000, 10000 }) {
+        QVERIFY(QDir().mkpath(corpusPath(count)));
+        m_files.insert(count, Corpus::generate(corpusPath(count), count));
+        QCOMPARE(m_files.value(count).size(), count);
+    }
+}
+
+void BenchLauncherModel::addCorpusRows()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+QString BenchLauncherModel::corpusPath(int count) const
+{
+    return QStringLiteral("%1/%2").arg(m_corpusDir.path()).arg(count);
+}
+
+void BenchLauncherModel::clearAppList()
+{
+    QSettings settings("cutefishos", "launcher-applist");
+    settings.clear();
+    settings.sync();
+}
+
+LauncherModel *BenchLauncherModel::loadModel(int count)
+{
+    clearAppList();
+
+    LauncherModel *model = new LauncherModel(corpusPath(count), this);
+    QSignalSpy spy(model, &LauncherModel::refreshed);
+
+    if (!spy.wait(60000)) {
+        delete model;
+        return nullptr;
+    }
+
+    return model;
+}
+
+void BenchLauncherModel::parse_data()
+{
+    addCorpusRows();
+}
+
+void BenchLauncherModel::parse()
+{
+    QFETCH(int, count);
+    const QStringList files = m_files.value(count);
+
+    QBENCHMARK {
+        for (const QString &file : files) {
+            DesktopProperties desktop(file, "Desktop Entry");
+            desktop.value("Name");
+        }
+    }
+}
+
+void BenchLauncherModel::fullRefresh_data()
+{
+    addCorpusRows();
+}
+
+void BenchLauncherModel::fullRefresh()
+{
+    QFETCH(int, count);
+
+    // Cold: nothing saved, every file is parsed and inserted.
+    QBENCHMARK {
+        QScopedPointer<LauncherModel> model(loadModel(count));
+        QVERIFY(model);
+        QCOMPARE(model->count(), Corpus::visibleCount(count));
+    }
+}
+
+void BenchLauncherModel::incrementalChange_data()
+{
+    addCorpusRows();
+}
+
+void BenchLauncherModel::incrementalChange()
+{
+    QFETCH(int, count);
+
+    QScopedPointer<LauncherModel> model(loadModel(count));
+    QVERIFY(model);
+
+    const QString file = m_files.value(count).first();
+    int revision = 0;
+
+    // refresh() runs on the calling thread here, so addApp() is called
+    // directly and the whole pass is measured.
+    QBENCHMARK {
+        Corpus::touch(file, ++revision);
+        LauncherModel::refresh(model.data());
+    }
+
+    Corpus::touch(file, 0);
+}
+
+void BenchLauncherModel::searchPerKeystroke_data()
+{
+    addCorpusRows();
+}
+
+void BenchLauncherModel::searchPerKeystroke()
+{
+    QFETCH(int, count);
+
+    QScopedPointer<LauncherModel> model(loadModel(count));
+    QVERIFY(model);
+
+    const QString word = QStringLiteral("calculator");
+
+    QBENCHMARK {
+        for (int i = 1; i <= word.size(); ++i)
+            model->search(word.left(i));
+
+        model->search(QString());
+    }
+}
+
+void BenchLauncherModel::filteredSearch_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<QString>("query");
+
+    static const char *const queries[][2] = {
+        { "text", "calculator" },
+        { "category", "cat:graphics calculator" },
+        { "exclusion", "cat:graphics -pinned: -new: -viewer" },
+    };
+
+    for (int count : { 100, 1000, 10000 }) {
+        for (const auto &query : queries) {
+            QTest::newRow(qPrintable(QStringLiteral("%1 %2").arg(count).arg(QLatin1String(query[0]))))
+                    << count << QString::fromLatin1(query[1]);
+        }
+    }
+}
+
+void BenchLauncherModel::filteredSearch()
+{
+    QFETCH(int, count);
+    QFETCH(QString, query);
+
+    QScopedPointer<LauncherModel> model(loadModel(count));
+    QVERIFY(model);
+
+    // The first search builds the bitsets, the others reuse them.
+    model->search(query);
+
+    QBENCHMARK {
+        model->search(query);
+    }
+
+    model->search(QString());
+}
+
+void BenchLauncherModel::paging_data()
+{
+    addCorpusRows();
+}
+
+void BenchLauncherModel::paging()
+{
+    QFETCH(int, count);
+
+    QScopedPointer<LauncherModel> model(loadModel(count));
+    QVERIFY(model);
+
+    // The size of a page on a 1080p screen.
+    const int pageSize = 7 * 4;
+
+    PageModel page;
+    page.setSourceModel(model.data());
+    page.setLimitCount(pageSize);
+
+    QBENCHMARK {
+        for (int start = 0; start < model->count(); start += pageSize) {
+            page.setStartIndex(start);
+
+            for (int row = 0; row < page.rowCount(); ++row) {
+                const QModelIndex index = page.index(row, 0);
+                page.data(index, LauncherModel::NameRole);
+                page.data(index, LauncherModel::IconNameRole);
+            }
+        }
+    }
+}
+
+void BenchLauncherModel::persistence_data()
+{
+    addCorpusRows();
+}
+
+void BenchLauncherModel::persistence()
+{
+    QFETCH(int, count);
+
+    QScopedPointer<LauncherModel> model(loadModel(count));
+    QVERIFY(model);
+
+    QBENCHMARK {
+        model->save();
+
+        QSettings settings("cutefishos", "launcher-applist");
+        settings.sync();
+
+        QByteArray data = settings.value("list").toByteArray();
+        QDataStream in(&data, QIODevice::ReadOnly);
+        QList<AppItem> items;
+        in >> items;
+
+        QCOMPARE(items.size(), model->count());
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchLauncherModel)
+
+#include "bench_launchermodel.moc"
@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "corpus.h"
+#include "launchermodel.h"
+#include "pagemodel.h"
+#include "iconitem.h"
+#include "iconcache.h"
+#include "appmanager.h"
+#include "blurredwallpaper.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QQuickView>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtTest>
+
+#include <algorithm>
+
+#include <sys/resource.h>
+
+/**
+ * Loads the real main.qml against a synthetic app set and drives page
+ * flicks and typed searches through it.
+ *
+ * Meant for machines without a GPU: unless set otherwise it runs on the
+ * offscreen platform with the software scene graph. Reports frame time
+ * percentiles, how many items and objects exist and the peak RSS.
+ */
+
+// Stands in for Launcher, which needs the session bus and a real screen.
+class BenchLauncher : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QRect screenRect READ screenRect CONSTANT)
+    Q_PROPERTY(bool showed READ showed CONSTANT)
+    Q_PROPERTY(int leftMargin READ margin CONSTANT)
+    Q_PROPERTY(int rightMargin READ margin CONSTANT)
+    Q_PROPERTY(int bottomMargin READ margin CONSTANT)
+
+public:
+    explicit BenchLauncher(const QRect &screenRect, QObject *parent = nullptr)
+        : QObject(parent), m_screenRect(screenRect) { }
+
+    QRect screenRect() const { return m_screenRect; }
+    bool showed() const { return true; }
+    int margin() const { return 0; }
+
+    Q_INVOKABLE void showWindow() { }
+    Q_INVOKABLE void hideWindow() { }
+    Q_INVOKABLE void toggle() { }
+    Q_INVOKABLE bool dockAvailable() { return false; }
+    Q_INVOKABLE void clearPixmapCache() { }
+
+signals:
+    void visibleChanged(bool visible);
+
+private:
+    QRect m_screenRect;
+};
+
+class FrameRecorder : public QObject
+{
+public:
+    explicit FrameRecorder(QQuickWindow *window)
+        : QObject(window)
+    {
+        // A frame starts with the update request on the GUI thread, before
+        // polishItems(), where views create and recycle their delegates.
+        // afterAnimating and beforeSynchronizing only come after that.
+        window->installEventFilter(this);
+
+        // The software render loop runs on the GUI thread, the threaded
+        // one swaps on the render thread.
+        connect(window, &QQuickWindow::frameSwapped, this, [this] {
+            QMutexLocker locker(&m_mutex);
+            if (m_frameTimer.isValid())
+                m_frames.append(m_frameTimer.nsecsElapsed());
+            m_frameTimer.invalidate();
+        }, Qt::DirectConnection);
+    }
+
+    QVector<qint64> take()
+    {
+        QMutexLocker locker(&m_mutex);
+        QVector<qint64> frames;
+        frames.swap(m_frames);
+        return frames;
+    }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::UpdateRequest) {
+            // The frame is produced while this event is handled.
+            QMutexLocker locker(&m_mutex);
+            m_frameTimer.start();
+        }
+
+        return QObject::eventFilter(watched, event);
+    }
+
+private:
+    QMutex m_mutex;
+    QElapsedTimer m_frameTimer;
+    QVector<qint64> m_frames;
+};
+
+struct Phase {
+    QString name;
+    QVector<qint64> frames;
+    int items = 0;
+    int objects = 0;
+};
+
+static int countItems(QQuickItem *item)
+{
+    int count = 1;
+
+    for (QQuickItem *child : item->childItems())
+        count += countItems(child);
+
+    return count;
+}
+
+static qreal percentile(const QVector<qint64> &sorted, qreal p)
+{
+    if (sorted.isEmpty())
+        return 0;
+
+    // Nearest rank.
+    const int rank = qBound(1, int(std::ceil(p / 100.0 * sorted.size())), sorted.size());
+    return sorted.at(rank - 1) / 1000000.0;
+}
+
+static long peakRssKiB()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    // Linux reports kilobytes.
+    return usage.ru_maxrss;
+}
+
+static void takeSnapshot(Phase &phase, QQuickView &view, FrameRecorder *recorder)
+{
+    phase.frames = recorder->take();
+    std::sort(phase.frames.begin(), phase.frames.end());
+    phase.items = countItems(view.contentItem());
+    phase.objects = view.rootObject() ? view.rootObject()->findChildren<QObject *>().size() + 1 : 0;
+}
+
+static void typeText(QQuickView &view, QQuickItem *field, const QString &text)
+{
+    QMetaObject::invokeMethod(field, "forceActiveFocus");
+
+    for (const QChar &c : text) {
+        QTest::keyClick(&view, c.toLatin1());
+        QTest::qWait(80);
+    }
+
+    // Past the search debounce in main.qml, then let the pages settle.
+    QTest::qWait(700);
+
+    field->setProperty("text", QString());
+    QTest::qWait(200);
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    if (qEnvironmentVariableIsEmpty("QT_QUICK_BACKEND"))
+        qputenv("QT_QUICK_BACKEND", "software");
+
+    QByteArray uri = "Cutefish.Launcher";
+    qmlRegisterType<LauncherModel>(uri, 1, 0, "LauncherModel");
+    qmlRegisterType<PageModel>(uri, 1, 0, "PageModel");
+    qmlRegisterType<IconItem>(uri, 1, 0, "IconItem");
+    qmlRegisterType<AppManager>(uri, 1, 0, "AppManager");
+    qmlRegisterType<BlurredWallpaper>(uri, 1, 0, "BlurredWallpaper");
+#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
+    qmlRegisterType<QAbstractItemModel>();
+#else
+    qmlRegisterAnonymousType<QAbstractItemModel>(uri, 0);
+#endif
+
+    QApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("bench_qml"));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption appsOption(QStringLiteral("apps"), "Number of synthetic apps.", "count", "1000");
+    QCommandLineOption flicksOption(QStringLiteral("flicks"), "Page flicks in each direction.", "count", "20");
+    QCommandLineOption sizeOption(QStringLiteral("size"), "Window size.", "WxH", "1920x1080");
+    QCommandLineOption jsonOption(QStringLiteral("json"), "Also write the results to a JSON file.", "file");
+    parser.addOptions({ appsOption, flicksOption, sizeOption, jsonOption });
+    parser.process(app);
+
+    const int apps = parser.value(appsOption).toInt();
+    const int flicks = parser.value(flicksOption).toInt();
+    const QStringList size = parser.value(sizeOption).split('x');
+    const QRect screenRect(0, 0, size.value(0).toInt(), size.value(1).toInt());
+
+    QTextStream out(stdout);
+    out.setFieldAlignment(QTextStream::AlignLeft);
+
+    QTemporaryDir configDir;
+    QTemporaryDir corpusDir;
+    if (!configDir.isValid() || !corpusDir.isValid() || screenRect.isEmpty())
+        return 1;
+
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, configDir.path());
+    Corpus::generate(corpusDir.path(), apps);
+
+    LauncherModel model(corpusDir.path());
+    QSignalSpy refreshed(&model, &LauncherModel::refreshed);
+    if (!refreshed.wait(60000)) {
+        out << "The model did not finish loading" << "\n";
+        return 1;
+    }
+
+    BenchLauncher launcher(screenRect);
+
+    QQuickView view;
+    view.rootContext()->setContextProperty("launcher", &launcher);
+    view.rootContext()->setContextProperty("launcherModel", &model);
+    view.rootContext()->setContextProperty("iconCache", IconCache::self());
+    view.setResizeMode(QQuickView::SizeRootObjectToView);
+    view.resize(screenRect.size());
+
+    FrameRecorder *recorder = new FrameRecorder(&view);
+    QVector<Phase> phases;
+
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+    view.setSource(QUrl(QStringLiteral("qrc:/qml/main.qml")));
+
+    if (view.status() != QQuickView::Ready) {
+        for (const QQmlError &error : view.errors())
+            out << error.toString() << "\n";
+        return 1;
+    }
+
+    view.show();
+    if (!QTest::qWaitForWindowExposed(&view))
+        return 1;
+    QTest::qWait(500);
+    const qint64 loadTime = loadTimer.elapsed();
+
+    Phase load;
+    load.name = QStringLiteral("load");
+    takeSnapshot(load, view, recorder);
+    phases.append(load);
+
+    QQuickItem *appView = view.rootObject()->findChild<QQuickItem *>(QStringLiteral("appView"));
+    QQuickItem *searchField = view.rootObject()->findChild<QQuickItem *>(QStringLiteral("searchField"));
+    if (!appView || !searchField) {
+        out << "appView or searchField not found in main.qml" << "\n";
+        return 1;
+    }
+
+    // Same path as the wheel and the keyboard, each scroll animates for 300 ms.
+    for (int i = 0; i < flicks; ++i) {
+        QMetaObject::invokeMethod(appView, "scrollNextPage");
+        QTest::qWait(350);
+    }
+    for (int i = 0; i < flicks; ++i) {
+        QMetaObject::invokeMethod(appView, "scrollPreviousPage");
+        QTest::qWait(350);
+    }
+
+    Phase paging;
+    paging.name = QStringLiteral("paging");
+    takeSnapshot(paging, view, recorder);
+    phases.append(paging);
+
+    for (const QString &query : { QStringLiteral("calculator"), QStringLiteral("music player"),
+                                  QStringLiteral("viewer 12"), QStringLiteral("zzz") })
+        typeText(view, searchField, query);
+
+    Phase search;
+    search.name = QStringLiteral("search");
+    takeSnapshot(search, view, recorder);
+    phases.append(search);
+
+    const long peakRss = peakRssKiB();
+
+    out << "apps " << apps << ", " << screenRect.width() << "x" << screenRect.height()
+        << ", " << QQuickWindow::sceneGraphBackend() << " scene graph" << "\n";
+    out << "load " << loadTime << " ms, peak RSS " << peakRss << " KiB" << "\n";
+    out << qSetFieldWidth(10) << "phase" << "frames" << "p50 ms" << "p90 ms"
+        << "p99 ms" << "max ms" << "items" << "objects" << qSetFieldWidth(0) << "\n";
+
+    QJsonArray jsonPhases;
+
+    for (const Phase &phase : qAsConst(phases)) {
+        out << qSetFieldWidth(10) << phase.name << phase.frames.size()
+            << QString::number(percentile(phase.frames, 50), 'f', 2)
+            << QString::number(percentile(phase.frames, 90), 'f', 2)
+            << QString::number(percentile(phase.frames, 99), 'f', 2)
+            << QString::number(percentile(phase.frames, 100), 'f', 2)
+            << phase.items << phase.objects << qSetFieldWidth(0) << "\n";
+
+        QJsonObject object;
+        object.insert("name", phase.name);
+        object.insert("frames", phase.frames.size());
+        object.insert("p50", percentile(phase.frames, 50));
+        object.insert("p90", percentile(phase.frames, 90));
+        object.insert("p99", percentile(phase.frames, 99));
+        object.insert("max", percentile(phase.frames, 100));
+        object.insert("items", phase.items);
+        object.insert("objects", phase.objects);
+        jsonPhases.append(object);
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject result;
+        result.insert("apps", apps);
+        result.insert("loadMs", loadTime);
+        result.insert("peakRssKiB", double(peakRss));
+        result.insert("phases", jsonPhases);
+
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly))
+            return 1;
+        file.write(QJsonDocument(result).toJson());
+    }
+
+    return 0;
+}
+
+#include "bench_qml.moc"
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "corpus.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+
+namespace Corpus {
+
+static const char *const s_words[] = {
+    "Text", "Editor", "Browser", "Music", "Player", "Image", "Viewer", "Terminal",
+    "Calculator", "Mail", "Office", "Video", "Settings", "Files", "Calendar", "Chess"
+};
+static const int s_wordCount = sizeof(s_words) / sizeof(s_words[0]);
+
+// Main categories, so "cat:" filters keep a part of the entries.
+static const char *const s_categories[] = {
+    "Development", "Graphics", "AudioVideo", "Office", "Network", "Game", "System"
+};
+static const int s_categoryCount = sizeof(s_categories) / sizeof(s_categories[0]);
+
+static bool isHidden(int index)
+{
+    return index % 20 == 19;
+}
+
+static QString entryName(int index, int revision)
+{
+    return QStringLiteral("%1 %2 %3")
+            .arg(QLatin1String(s_words[index % s_wordCount]))
+            .arg(QLatin1String(s_words[(index / s_wordCount + revision) % s_wordCount]))
+            .arg(index);
+}
+
+static bool write(const QString &fileName, int index, int revision)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    const QString name = entryName(index, revision);
+
+    QTextStream out(&file);
+    out << "[Desktop Entry]\n"
+        << "Type=Application\n"
+        << "Version=1.0\n"
+        << "Name=" << name << "\n"
+        << "Name[de]=" << name << " (de)\n"
+        << "Name[zh_CN]=" << name << " (zh)\n"
+        << "GenericName=" << s_words[index % s_wordCount] << "\n"
+        << "Comment=Synthetic entry number " << index << "\n"
+        << "Comment[de]=Synthetischer Eintrag " << index << "\n"
+        << "Icon=bench-icon-" << index % 64 << "\n"
+        // An executable that exists, entries with a missing one are hidden.
+        << "Exec=/bin/sh /usr/bin/bench-app-" << index << " --flag %U\n"
+        << "TryExec=sh\n"
+        << "Terminal=false\n"
+        << "Categories=Utility;" << s_categories[index % s_categoryCount] << ";\n"
+        << "Keywords=bench;" << s_words[(index + 3) % s_wordCount] << ";\n"
+        << "Actions=new-window;\n";
+
+    if (isHidden(index))
+        out << "NoDisplay=true\n";
+
+    out << "\n[Desktop Action new-window]\n"
+        << "Name=New Window\n"
+        << "Exec=/usr/bin/bench-app-" << index << " --new-window\n";
+
+    out.flush();
+    file.close();
+
+    // Keep modification times apart even on filesystems with coarse timestamps.
+    const QDateTime time = QDateTime::fromSecsSinceEpoch(1600000000 + revision);
+    if (!file.open(QIODevice::ReadWrite))
+        return false;
+
+    return file.setFileTime(time, QFileDevice::FileModificationTime);
+}
+
+static QString fileName(const QString &directory, int index)
+{
+    return QStringLiteral("%1/bench-app-%2.desktop").arg(directory).arg(index);
+}
+
+QStringList generate(const QString &directory, int count)
+{
+    QStringList files;
+    files.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        const QString file = fileName(directory, i);
+        if (write(file, i, 0))
+            files.append(file);
+    }
+
+    return files;
+}
+
+int visibleCount(int count)
+{
+    int visible = 0;
+
+    for (int i = 0; i < count; ++i) {
+        if (!isHidden(i))
+            ++visible;
+    }
+
+    return visible;
+}
+
+void touch(const QString &fileName, int revision)
+{
+    // The index is the number in "bench-app-<index>.desktop".
+    const int start = fileName.lastIndexOf('-') + 1;
+    const int index = fileName.mid(start, fileName.lastIndexOf('.') - start).toInt();
+
+    write(fileName, index, revision);
+}
+
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * Writes synthetic .desktop files for the benchmarks.
+ *
+ * The content is deterministic: names are built from a small word list so
+ * searches hit a realistic share of the entries, every entry carries a few
+ * translations and actions, and one in twenty is NoDisplay.
+ */
+namespace Corpus {
+
+// Returns the files written to directory.
+QStringList generate(const QString &directory, int count);
+
+// Number of generated entries the launcher shows.
+int visibleCount(int count);
+
+// Rewrites one entry with another name and a newer modification time.
+void touch(const QString &fileName, int revision);
+
+}
+
+#endif // CORPUS_H
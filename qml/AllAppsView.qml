@@ -17,7 +17,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-import QtQuick 2.12
+import QtQuick 2.15
+import QtQml 2.12
 import QtQuick.Controls 2.12
 import QtQuick.Layouts 1.12
 import FishUI 1.0 as FishUI
@@ -40,6 +41,9 @@ ListView {
     property int columns: control.height / control.cellHeight
     property int pageCount: control.rows * control.columns
 
+    // Shared by every label instead of one TextMetrics per delegate.
+    property real labelHeight: labelMetrics.height * 2
+
     orientation: ListView.Horizontal
     snapMode: ListView.SnapOneItem
     model: Math.ceil(control.modelCount / control.pageCount)
@@ -52,7 +56,10 @@ ListView {
     highlightRangeMode: ListView.StrictlyEnforceRange
     highlightFollowsCurrentItem: true
 
-    cacheBuffer: control.width * control.count
+    // Only the current page and its neighbours exist, pages scrolled out
+    // of the buffer are handed back with their delegates for reuse.
+    cacheBuffer: control.width
+    reuseItems: true
     boundsBehavior: Flickable.DragOverBounds
     currentIndex: -1
     clip: true
@@ -73,6 +80,102 @@ ListView {
         }
     }
 
+    FontMetrics {
+        id: labelMetrics
+    }
+
+    // Resting on an icon is as good a hint as pressing it.
+    Timer {
+        id: prewarmTimer
+        interval: 400
+
+        property string appId
+
+        onTriggered: launcherModel.prewarm(appId)
+    }
+
+    // One context menu for all items, created the first time it is needed.
+    Loader {
+        id: itemMenuLoader
+        active: false
+        sourceComponent: Component {
+            FishUI.DesktopMenu {
+                id: _itemMenu
+
+                property string appId
+                property string appName
+                property bool dockAvailable: false
+                property bool pinned: false
+                property var desktopActions: []
+
+                Connections {
+                    target: launcherModel
+
+                    function onPinnedChanged(id, pinned) {
+                        if (id === _itemMenu.appId)
+                            _itemMenu.pinned = pinned
+                    }
+                }
+
+                MenuItem {
+                    text: qsTr("Open")
+                    onTriggered: launcherModel.launch(_itemMenu.appId)
+                }
+
+                // Actions of the desktop file, e.g. "New Window", after "Open".
+                Instantiator {
+                    model: _itemMenu.desktopActions
+
+                    MenuItem {
+                        text: modelData.name
+                        onTriggered: launcherModel.launchAction(_itemMenu.appId, modelData.id)
+                    }
+
+                    onObjectAdded: _itemMenu.insertItem(index + 1, object)
+                    onObjectRemoved: _itemMenu.removeItem(object)
+                }
+
+                MenuItem {
+                    id: sendToDock
+                    text: qsTr("Send to dock")
+                    visible: _itemMenu.dockAvailable && !_itemMenu.pinned
+                    onTriggered: launcherModel.sendToDock(_itemMenu.appId)
+                }
+
+                MenuItem {
+                    id: sendToDesktop
+                    text: qsTr("Send to desktop")
+                    onTriggered: launcherModel.sendToDesktop(_itemMenu.appId)
+                }
+
+                MenuItem {
+                    id: removeFromDock
+                    text: qsTr("Remove from dock")
+                    visible: _itemMenu.dockAvailable && _itemMenu.pinned
+                    onTriggered: launcherModel.removeFromDock(_itemMenu.appId)
+                }
+
+                MenuItem {
+                    id: uninstallItem
+                    text: qsTr("Uninstall")
+                    onTriggered: {
+                        root.uninstallDialog.desktopPath = _itemMenu.appId
+                        root.uninstallDialog.appName = _itemMenu.appName
+                        root.uninstallDialog.visible = true
+                    }
+                }
+
+                function updateActions() {
+                    uninstallItem.visible = appManager.isCutefishOS()
+                    dockAvailable = launcher.dockAvailable()
+                    pinned = launcherModel.isPinned(appId)
+                    desktopActions = launcherModel.actions(appId)
+                    launcherModel.revalidatePinned(appId)
+                }
+            }
+        }
+    }
+
     DropArea {
         anchors.fill: parent
         z: -1
@@ -106,6 +209,7 @@ ListView {
         cellWidth: control.cellWidth
 
         interactive: false
+        reuseItems: true
 
         moveDisplaced: Transition {
             NumberAnimation {
@@ -124,11 +228,83 @@ ListView {
 
         delegate: GridItemDelegate {
             searchMode: control.searchMode
-            pageIndex: _page.pageIndex
-            pageCount: control.pageCount
+            labelHeight: control.labelHeight
             width: control.cellWidth
             height: control.cellHeight
+
+            onContextMenuRequested: control.openItemMenu(model.appId, model.name)
+
+            onIconHoveredChanged: {
+                if (iconHovered) {
+                    prewarmTimer.appId = model.appId
+                    prewarmTimer.restart()
+                } else if (prewarmTimer.appId === model.appId) {
+                    prewarmTimer.stop()
+                }
+            }
         }
+
+        // Reordering is handled per page rather than by every delegate.
+        DropArea {
+            id: _dropArea
+            anchors.fill: parent
+            enabled: !control.searchMode
+
+            property var dragSource: null
+            property int targetIndex: -1
+
+            onPositionChanged: {
+                var item = _page.itemAt(drag.x + _page.contentX, drag.y + _page.contentY)
+                var index = -1
+
+                if (item && item.iconContains(mapToItem(item, drag.x, drag.y)))
+                    index = _page.indexAt(drag.x + _page.contentX, drag.y + _page.contentY)
+
+                if (index === targetIndex)
+                    return
+
+                targetIndex = index
+
+                if (index !== -1 && drag.source) {
+                    dragSource = drag.source
+                    _dragTimer.restart()
+                } else {
+                    dragSource = null
+                    _dragTimer.stop()
+                }
+            }
+
+            onExited: {
+                targetIndex = -1
+                dragSource = null
+                _dragTimer.stop()
+            }
+        }
+
+        Timer {
+            id: _dragTimer
+            interval: 300
+            onTriggered: {
+                if (_dropArea.dragSource) {
+                    launcherModel.move(_dropArea.dragSource.dragItemIndex,
+                                       _dropArea.targetIndex,
+                                       _page.pageIndex,
+                                       control.pageCount)
+                    _pageModel.move(_dropArea.dragSource.dragItemIndex,
+                                    _dropArea.targetIndex)
+                }
+            }
+        }
+    }
+
+    function openItemMenu(appId, appName) {
+        itemMenuLoader.active = true
+
+        var menu = itemMenuLoader.item
+        menu.appId = appId
+        menu.appName = appName
+        menu.updateActions()
+        menu.popup()
     }
 
     function calcExtraSpacing(cellSize, containerSize) {
@@ -31,10 +31,12 @@ Item {
     property bool searchMode: false
     property bool dragStarted: false
     property var dragItemIndex: index
-    property var dragSource: null
 
-    property int pageIndex: 0
-    property int pageCount: 0
+    property real labelHeight: 0
+
+    readonly property alias iconHovered: iconMouseArea.containsMouse
+
+    signal contextMenuRequested()
 
     Drag.active: iconMouseArea.drag.active
     Drag.mimeData: [model.appId]
@@ -52,39 +54,6 @@ Item {
         dragStarted = false
     }
 
-    DropArea {
-        anchors.fill: icon
-        enabled: true
-
-        onContainsDragChanged: {
-            if (control.searchMode)
-                return
-
-            if (drag.source) {
-                control.dragSource = drag.source
-                dragTimer.restart()
-            } else {
-                control.dragSource = null
-                dragTimer.stop()
-            }
-        }
-    }
-
-    Timer {
-        id: dragTimer
-        interval: 300
-        onTriggered: {
-            if (control.dragSource) {
-                launcherModel.move(control.dragSource.dragItemIndex,
-                                   control.dragItemIndex,
-                                   control.pageIndex,
-                                   control.pageCount)
-                _pageModel.move(control.dragSource.dragItemIndex,
-                                control.dragItemIndex)
-            }
-        }
-    }
-
     IconItem {
         id: icon
 
@@ -99,77 +68,35 @@ Item {
         source: model.iconName
         visible: !dragStarted
 
-        ColorOverlay {
-            id: colorOverlay
-            anchors.fill: icon
-            source: icon
-            color: "#000000"
-            opacity: 0.5
-            visible: iconMouseArea.pressed
-        }
-    }
-
-    FishUI.DesktopMenu {
-        id: _itemMenu
-
-        MenuItem {
-            text: qsTr("Open")
-            onTriggered: launcherModel.launch(model.appId)
-        }
-
-        MenuItem {
-            id: sendToDock
-            text: qsTr("Send to dock")
-            onTriggered: launcherModel.sendToDock(model.appId)
-        }
-
-        MenuItem {
-            id: sendToDesktop
-            text: qsTr("Send to desktop")
-            onTriggered: launcherModel.sendToDesktop(model.appId)
-        }
-
-        MenuItem {
-            id: removeFromDock
-            text: qsTr("Remove from dock")
-            onTriggered: launcherModel.removeFromDock(model.appId)
-        }
-
-        MenuItem {
-            id: uninstallItem
-            text: qsTr("Uninstall")
-            onTriggered: {
-                root.uninstallDialog.desktopPath = model.appId
-                root.uninstallDialog.appName = model.name
-                root.uninstallDialog.visible = true
+        Loader {
+            anchors.fill: parent
+            active: iconMouseArea.pressed
+            sourceComponent: ColorOverlay {
+                source: icon
+                color: "#000000"
+                opacity: 0.5
             }
         }
-
-        // MenuItem {
-        //     text: qsTr("Uninstall")
-        //     onTriggered: {}
-        // }
-
-        function updateActions() {
-            sendToDock.visible = launcher.dockAvailable() && !launcher.isPinedDock(model.appId)
-            removeFromDock.visible = launcher.dockAvailable() && launcher.isPinedDock(model.appId)
-        }
     }
 
     MouseArea {
         id: iconMouseArea
         anchors.fill: icon
         acceptedButtons: Qt.LeftButton | Qt.RightButton
+        hoverEnabled: true
         drag.axis: Drag.XAndYAxis
 
+        // Use the time until release to read the application ahead.
+        onPressed: {
+            if (mouse.button == Qt.LeftButton)
+                launcherModel.prewarm(model.appId)
+        }
+
         onClicked: {
             if (mouse.button == Qt.LeftButton)
                 launcherModel.launch(model.appId)
-            else if (mouse.button == Qt.RightButton) {
-                uninstallItem.visible = appManager.isCutefishOS()
-                _itemMenu.updateActions()
-                _itemMenu.popup()
-            }
+            else if (mouse.button == Qt.RightButton)
+                control.contextMenuRequested()
         }
 
         onPositionChanged: {
@@ -190,10 +117,9 @@ Item {
         }
     }
 
-    TextMetrics {
-        id: fontMetrics
-        font.family: label.font.family
-        text: label.text
+    function iconContains(point) {
+        return point.x >= icon.x && point.x < icon.x + icon.width &&
+               point.y >= icon.y && point.y < icon.y + icon.height
     }
 
     Rectangle {
@@ -233,7 +159,7 @@ Item {
         horizontalAlignment: Text.AlignHCenter
         verticalAlignment: Text.AlignTop
         width: parent.width - 2 * FishUI.Units.smallSpacing
-        height: fontMetrics.height * 2
+        height: control.labelHeight
         color: "white"
 
         MouseArea {
@@ -164,28 +164,26 @@ Item {
         visible: backend.type === 1
     }
 
+    // Blurred once off the GUI thread and cached on disk, see BlurredWallpaper.
+    BlurredWallpaper {
+        id: wallpaperBlur
+        source: backend.type === 0 ? backend.path : ""
+        size: Qt.size(launcher.screenRect.width,
+                      launcher.screenRect.height)
+        radius: 72
+
+        onSourceChanged: launcher.clearPixmapCache()
+    }
+
     Image {
         id: wallpaperImage
         anchors.fill: parent
-        source: "file://" + backend.path
-        sourceSize: Qt.size(launcher.screenRect.width,
-                            launcher.screenRect.height)
+        source: wallpaperBlur.url
         fillMode: Image.PreserveAspectCrop
-        asynchronous: false
+        asynchronous: true
         cache: false
         smooth: true
         visible: backend.type === 0
-
-        onSourceChanged: launcher.clearPixmapCache()
-    }
-
-    FastBlur {
-        id: wallpaperBlur
-        anchors.fill: parent
-        radius: 72
-        source: wallpaperImage
-        cached: false
-        visible: wallpaperImage.visible
     }
 
     ColorOverlay {
@@ -197,10 +195,6 @@ Item {
         visible: true
     }
 
-    LauncherModel {
-        id: launcherModel
-    }
-
     Connections {
         target: launcherModel
 
@@ -230,6 +224,7 @@ Item {
 
             TextField {
                 id: textField
+                objectName: "searchField"
                 anchors.centerIn: parent
                 width: searchItem.width * 0.2
                 height: parent.height
@@ -319,6 +314,7 @@ Item {
 
             AllAppsView {
                 id: appView
+                objectName: "appView"
                 anchors.fill: parent
                 anchors.leftMargin: gridItem.width * 0.1
                 anchors.rightMargin: gridItem.width * 0.1
@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef APPINDEX_H
+#define APPINDEX_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * The app index the launcher publishes in $XDG_RUNTIME_DIR.
+ *
+ * This header is the whole reader: it has no Qt dependency so any shell
+ * component can include it, it is installed as
+ * <cutefish-launcher/appindex.h>. After Reader::open() has mapped the file,
+ * lookups are plain memory reads, no syscalls.
+ *
+ * Layout: Header, then rowCount Rows, bucketCount hash buckets (FNV-1a of
+ * the desktop id, chained through Row::next) and a string table of NUL
+ * terminated UTF-8 strings, offset 0 being the empty string. Row::exec
+ * points to the argv of the command line, consecutive strings ended by
+ * an empty one, so quoting does not need to be redone. Empty arguments
+ * are therefore not kept.
+ *
+ * The launcher rewrites the file in place and brackets every update with
+ * Header::sequence (odd while writing), readers retry until they see the
+ * same even value before and after reading. When the index outgrows the
+ * file a new one is renamed over it and the old one gets Header::stale
+ * set, readers then have to open() again.
+ */
+namespace AppIndex {
+
+static const char Magic[8] = { 'C', 'F', 'A', 'P', 'P', 'I', 'D', 'X' };
+static const uint32_t Version = 2;
+static const uint32_t None = 0xffffffff;
+
+enum Flag {
+    NewInstalled = 1 << 0
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t stale;
+    uint64_t sequence;
+    uint32_t rowCount;
+    uint32_t bucketCount;
+    uint32_t rowsOffset;
+    uint32_t bucketsOffset;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+};
+
+struct Row {
+    uint32_t id;
+    uint32_t name;
+    uint32_t genericName;
+    uint32_t comment;
+    uint32_t iconName;
+    uint32_t exec;
+    uint32_t flags;
+    uint32_t next;
+};
+
+struct Entry {
+    std::string id;
+    std::string name;
+    std::string genericName;
+    std::string comment;
+    std::string iconName;
+    std::vector<std::string> exec;
+    uint32_t flags = 0;
+};
+
+inline uint32_t hash(const char *data, size_t size)
+{
+    uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+inline std::string defaultPath()
+{
+    const char *runtimeDir = getenv("XDG_RUNTIME_DIR");
+
+    if (!runtimeDir || !*runtimeDir)
+        return std::string();
+
+    return std::string(runtimeDir) + "/cutefish-launcher-apps.idx";
+}
+
+class Reader
+{
+public:
+    Reader() {}
+    ~Reader() { close(); }
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    bool open(const std::string &path = defaultPath())
+    {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+            ::close(fd);
+            return false;
+        }
+
+        void *data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+            return false;
+
+        m_data = static_cast<const unsigned char *>(data);
+        m_size = size_t(st.st_size);
+
+        const Header *h = header();
+        if (memcmp(h->magic, Magic, sizeof(Magic)) != 0 || h->version != Version) {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void close()
+    {
+        if (m_data)
+            munmap(const_cast<unsigned char *>(m_data), m_size);
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    // True once the launcher replaced the file, open() again to follow it.
+    bool isStale() const
+    {
+        return !m_data || __atomic_load_n(&header()->stale, __ATOMIC_ACQUIRE) != 0;
+    }
+
+    bool find(const std::string &id, Entry *entry) const
+    {
+        bool found = false;
+
+        return consistentRead([&] (const Header &h) {
+            found = false;
+
+            const uint32_t *buckets = reinterpret_cast<const uint32_t *>(m_data + h.bucketsOffset);
+            uint32_t row = buckets[hash(id.data(), id.size()) & (h.bucketCount - 1)];
+
+            // Bounded, a torn read must not loop forever.
+            for (uint32_t steps = 0; row != None && steps < h.rowCount; ++steps) {
+                if (row >= h.rowCount)
+                    return false;
+
+                const Row &r = rows(h)[row];
+                const char *rowId = string(h, r.id);
+                if (!rowId)
+                    return false;
+
+                if (id == rowId) {
+                    found = true;
+                    return readRow(h, r, entry);
+                }
+
+                row = r.next;
+            }
+
+            return true;
+        }) && found;
+    }
+
+    bool readAll(std::vector<Entry> *entries) const
+    {
+        return consistentRead([&] (const Header &h) {
+            entries->resize(h.rowCount);
+
+            for (uint32_t i = 0; i < h.rowCount; ++i) {
+                if (!readRow(h, rows(h)[i], &(*entries)[i]))
+                    return false;
+            }
+
+            return true;
+        });
+    }
+
+private:
+    const Header *header() const { return reinterpret_cast<const Header *>(m_data); }
+
+    const Row *rows(const Header &h) const { return reinterpret_cast<const Row *>(m_data + h.rowsOffset); }
+
+    bool valid(const Header &h) const
+    {
+        return h.bucketCount > 0 && (h.bucketCount & (h.bucketCount - 1)) == 0
+                && uint64_t(h.rowsOffset) + uint64_t(h.rowCount) * sizeof(Row) <= m_size
+                && uint64_t(h.bucketsOffset) + uint64_t(h.bucketCount) * sizeof(uint32_t) <= m_size
+                && uint64_t(h.stringsOffset) + h.stringsSize <= m_size
+                && h.rowsOffset % alignof(Row) == 0 && h.bucketsOffset % alignof(uint32_t) == 0;
+    }
+
+    const char *string(const Header &h, uint32_t offset) const
+    {
+        if (offset >= h.stringsSize)
+            return nullptr;
+
+        const char *s = reinterpret_cast<const char *>(m_data + h.stringsOffset + offset);
+        return memchr(s, '\0', h.stringsSize - offset) ? s : nullptr;
+    }
+
+    bool readRow(const Header &h, const Row &r, Entry *entry) const
+    {
+        const char *strings[] = { string(h, r.id), string(h, r.name), string(h, r.genericName),
+                                  string(h, r.comment), string(h, r.iconName) };
+
+        for (const char *s : strings) {
+            if (!s)
+                return false;
+        }
+
+        entry->id = strings[0];
+        entry->name = strings[1];
+        entry->genericName = strings[2];
+        entry->comment = strings[3];
+        entry->iconName = strings[4];
+        entry->flags = r.flags;
+
+        entry->exec.clear();
+        for (uint32_t offset = r.exec;;) {
+            const char *argument = string(h, offset);
+            if (!argument)
+                return false;
+            if (!*argument)
+                break;
+
+            entry->exec.push_back(argument);
+            offset += uint32_t(strlen(argument)) + 1;
+        }
+
+        return true;
+    }
+
+    template <typename Read>
+    bool consistentRead(Read read) const
+    {
+        if (!m_data)
+            return false;
+
+        const Header *shared = header();
+
+        for (int attempt = 0; attempt < 1000; ++attempt) {
+            const uint64_t begin = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+            if (begin & 1)
+                continue;
+
+            Header h;
+            memcpy(&h, shared, sizeof(Header));
+
+            const bool ok = valid(h) && read(h);
+
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&shared->sequence, __ATOMIC_RELAXED) == begin)
+                return ok;
+        }
+
+        return false;
+    }
+
+private:
+    const unsigned char *m_data = nullptr;
+    size_t m_size = 0;
+};
+
+}
+
+#endif // APPINDEX_H
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "appindexwriter.h"
+#include "appindex.h"
+#include "launchermodel.h"
+
+#include <QStandardPaths>
+#include <QVector>
+#include <QFile>
+#include <QHash>
+#include <QtMath>
+#include <QDebug>
+
+#include <cstddef>
+
+// Room to grow before readers have to remap.
+static const qint64 MinimumCapacity = 64 * 1024;
+
+static quint32 align(quint32 offset)
+{
+    return (offset + 7) & ~quint32(7);
+}
+
+AppIndexWriter::AppIndexWriter(LauncherModel *model, QObject *parent)
+    : QObject(parent)
+    , m_model(model)
+    , m_data(nullptr)
+    , m_capacity(0)
+{
+    m_path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)
+            + QStringLiteral("/cutefish-launcher-apps.idx");
+
+    m_writeTimer.setInterval(0);
+    m_writeTimer.setSingleShot(true);
+    connect(&m_writeTimer, &QTimer::timeout, this, &AppIndexWriter::write);
+
+    connect(m_model, &LauncherModel::appsChanged, &m_writeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_model, &LauncherModel::refreshed, &m_writeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+
+    m_writeTimer.start();
+}
+
+AppIndexWriter::~AppIndexWriter()
+{
+    release();
+    QFile::remove(m_path);
+}
+
+QByteArray AppIndexWriter::build() const
+{
+    const QList<AppItem> &items = m_model->items();
+    const quint32 count = quint32(items.size());
+    const quint32 bucketCount = qMax<quint32>(16, qNextPowerOfTwo(count * 2));
+
+    QByteArray strings(1, '\0');
+    QHash<QByteArray, quint32> stringOffsets;
+
+    // utf8 may hold several strings, each with its NUL.
+    auto addBytes = [&] (const QByteArray &utf8) -> quint32 {
+        if (utf8.isEmpty())
+            return 0;
+
+        auto it = stringOffsets.constFind(utf8);
+        if (it != stringOffsets.constEnd())
+            return it.value();
+
+        const quint32 offset = quint32(strings.size());
+        strings.append(utf8);
+        strings.append('\0');
+        stringOffsets.insert(utf8, offset);
+        return offset;
+    };
+
+    auto addString = [&] (const QString &string) -> quint32 {
+        return addBytes(string.toUtf8());
+    };
+
+    // Ended by the empty string the table adds after them.
+    auto addArguments = [&] (const QStringList &arguments) -> quint32 {
+        QByteArray utf8;
+        for (const QString &argument : arguments) {
+            if (argument.isEmpty())
+                continue;
+            utf8.append(argument.toUtf8());
+            utf8.append('\0');
+        }
+        return addBytes(utf8);
+    };
+
+    QVector<AppIndex::Row> rows(int(count));
+    QVector<quint32> buckets(int(bucketCount), AppIndex::None);
+
+    for (quint32 i = 0; i < count; ++i) {
+        const AppItem &item = items.at(int(i));
+        AppIndex::Row &row = rows[int(i)];
+
+        row.id = addString(item.id);
+        row.name = addString(item.name);
+        row.genericName = addString(item.genericName);
+        row.comment = addString(item.comment);
+        row.iconName = addString(item.iconName);
+        row.exec = addArguments(item.exec.expand(QStringList(), item.iconName, item.name, item.id));
+        row.flags = item.newInstalled ? AppIndex::NewInstalled : 0;
+
+        const QByteArray id = item.id.toUtf8();
+        quint32 &bucket = buckets[int(AppIndex::hash(id.constData(), size_t(id.size())) & (bucketCount - 1))];
+        row.next = bucket;
+        bucket = i;
+    }
+
+    AppIndex::Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, AppIndex::Magic, sizeof(header.magic));
+    header.version = AppIndex::Version;
+    header.rowCount = count;
+    header.bucketCount = bucketCount;
+    header.rowsOffset = align(sizeof(AppIndex::Header));
+    header.bucketsOffset = align(header.rowsOffset + count * sizeof(AppIndex::Row));
+    header.stringsOffset = align(header.bucketsOffset + bucketCount * sizeof(quint32));
+    header.stringsSize = quint32(strings.size());
+
+    QByteArray data(int(header.stringsOffset + header.stringsSize), '\0');
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + header.rowsOffset, rows.constData(), count * sizeof(AppIndex::Row));
+    memcpy(data.data() + header.bucketsOffset, buckets.constData(), bucketCount * sizeof(quint32));
+    memcpy(data.data() + header.stringsOffset, strings.constData(), size_t(strings.size()));
+
+    return data;
+}
+
+void AppIndexWriter::write()
+{
+    const QByteArray data = build();
+
+    if (!m_data || data.size() > m_capacity) {
+        if (!replaceFile(data))
+            qWarning() << "Failed to publish the app index at" << m_path;
+        return;
+    }
+
+    // Seqlock: odd while the contents change, readers retry.
+    AppIndex::Header *header = reinterpret_cast<AppIndex::Header *>(m_data);
+    const quint64 sequence = __atomic_load_n(&header->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    // Everything after the sequence number, the rest of the header never changes.
+    const size_t offset = offsetof(AppIndex::Header, rowCount);
+    memcpy(m_data + offset, data.constData() + offset, size_t(data.size()) - offset);
+
+    __atomic_store_n(&header->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+bool AppIndexWriter::replaceFile(const QByteArray &data)
+{
+    const qint64 capacity = qMax<qint64>(MinimumCapacity, qNextPowerOfTwo(quint32(data.size())));
+    const QByteArray tempPath = QFile::encodeName(m_path + QStringLiteral(".new"));
+
+    const int fd = ::open(tempPath.constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+
+    void *mapped = MAP_FAILED;
+    if (::ftruncate(fd, capacity) == 0)
+        mapped = ::mmap(nullptr, size_t(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (mapped == MAP_FAILED) {
+        ::unlink(tempPath.constData());
+        return false;
+    }
+
+    memcpy(mapped, data.constData(), size_t(data.size()));
+
+    if (::rename(tempPath.constData(), QFile::encodeName(m_path).constData()) != 0) {
+        ::munmap(mapped, size_t(capacity));
+        ::unlink(tempPath.constData());
+        return false;
+    }
+
+    release();
+
+    m_data = static_cast<uchar *>(mapped);
+    m_capacity = capacity;
+
+    return true;
+}
+
+void AppIndexWriter::release()
+{
+    if (!m_data)
+        return;
+
+    // Tell readers of the old file to open the new one.
+    __atomic_store_n(&reinterpret_cast<AppIndex::Header *>(m_data)->stale, 1u, __ATOMIC_RELEASE);
+    ::munmap(m_data, size_t(m_capacity));
+
+    m_data = nullptr;
+    m_capacity = 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef APPINDEXWRITER_H
+#define APPINDEXWRITER_H
+
+#include <QObject>
+#include <QTimer>
+
+class LauncherModel;
+
+/**
+ * Publishes the launcher model as the memory-mapped index described in
+ * appindex.h, rewriting it whenever the apps change.
+ */
+class AppIndexWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AppIndexWriter(LauncherModel *model, QObject *parent = nullptr);
+    ~AppIndexWriter();
+
+private slots:
+    void write();
+
+private:
+    QByteArray build() const;
+    bool replaceFile(const QByteArray &data);
+    void release();
+
+private:
+    LauncherModel *m_model;
+    QTimer m_writeTimer;
+    QString m_path;
+    uchar *m_data;
+    qint64 m_capacity;
+};
+
+#endif // APPINDEXWRITER_H
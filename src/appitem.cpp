@@ -31,8 +31,11 @@ AppItem::AppItem(const AppItem &info)
     , genericName(info.genericName)
     , comment(info.comment)
     , iconName(info.iconName)
-    , args(info.args)
-    , newInstalled(false)
+    , exec(info.exec)
+    , tryExec(info.tryExec)
+    , categories(info.categories)
+    , sortKey(info.sortKey)
+    , newInstalled(info.newInstalled)
 {
 
 }
@@ -42,6 +45,19 @@ AppItem::~AppItem()
 
 }
 
+bool AppItem::lessThan(const AppItem &a, const AppItem &b)
+{
+    // A different comparison for items without a key would not be a
+    // consistent order, see LauncherModel::ensureSortKeys().
+    Q_ASSERT(a.sortKey && b.sortKey);
+    return a.sortKey->compare(*b.sortKey) < 0;
+}
+
+QString AppItem::executable() const
+{
+    return tryExec.isEmpty() ? exec.program() : tryExec;
+}
+
 QDataStream &operator<<(QDataStream &argument, const AppItem &info)
 {
     argument << info.id << info.name << info.genericName;
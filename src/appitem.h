@@ -23,10 +23,16 @@
 #include <QString>
 #include <QStringList>
 #include <QMetaType>
+#include <QCollator>
+#include <QSharedPointer>
+
+#include "exectemplate.h"
 
 class AppItem
 {
 public:
+    typedef QSharedPointer<const QCollatorSortKey> SortKey;
+
     AppItem();
     AppItem(const AppItem &info);
     ~AppItem();
@@ -35,16 +41,37 @@ public:
     friend QDataStream &operator<<(QDataStream &argument, const AppItem &info);
     friend const QDataStream &operator>>(QDataStream &argument, AppItem &info);
 
+    // Collation order of the names, both need a sortKey.
+    static bool lessThan(const AppItem &a, const AppItem &b);
+
+    // TryExec if there is one, the program of Exec otherwise.
+    QString executable() const;
+
     QString id;
     QString name;
     QString genericName;
     QString comment;
     QString iconName;
-    QStringList args;
+    ExecTemplate exec;
+    QString tryExec;
+    QStringList categories;
+
+    // Computed from name for the current locale, not saved.
+    SortKey sortKey;
 
     bool newInstalled;
 };
 
+// A [Desktop Action] group, read when the actions of an entry are first
+// asked for.
+struct AppAction
+{
+    QString id;
+    QString name;
+    QString iconName;
+    ExecTemplate exec;
+};
+
 Q_DECLARE_METATYPE(AppItem)
 
 #endif // APPITEM_H
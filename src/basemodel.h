@@ -4,6 +4,14 @@
 #include <QPoint>
 #include <QAbstractListModel>
 #include <QList>
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #if defined(QT_TESTLIB_LIB)
 #  define BaseModel_ASSERT(x)
@@ -18,6 +26,124 @@ struct QBaseModelListGuard
 {
 };
 
+// A run of rows that differs between two lists: oldCount rows at oldStart
+// were replaced by newCount rows at newStart.
+struct DiffHunk
+{
+    int oldStart;
+    int oldCount;
+    int newStart;
+    int newCount;
+};
+
+// Myers' O((N+M)D) diff of two sequences compared through equal(oldRow, newRow),
+// after skipping the common prefix and suffix. Gives up and returns false if
+// more than maxCost edits are needed, the caller is better off resetting then.
+template <typename Equal>
+bool diffRows(int oldCount, int newCount, Equal equal, int maxCost, QVector<DiffHunk> &hunks)
+{
+    int prefix = 0;
+    while (prefix < oldCount && prefix < newCount && equal(prefix, prefix))
+        ++prefix;
+
+    int suffix = 0;
+    while (suffix < oldCount - prefix && suffix < newCount - prefix
+           && equal(oldCount - 1 - suffix, newCount - 1 - suffix))
+        ++suffix;
+
+    const int n = oldCount - prefix - suffix;
+    const int m = newCount - prefix - suffix;
+
+    if (n == 0 && m == 0)
+        return true;
+
+    if (n == 0 || m == 0) {
+        hunks.append({ prefix, n, prefix, m });
+        return true;
+    }
+
+    const int max = qMin(n + m, maxCost);
+    const int offset = max + 1;
+    QVector<int> v(2 * max + 3, 0);
+
+    // The furthest x of every diagonal after each round d is kept for the
+    // way back, round d starts at d * d.
+    QVector<int> trace;
+    int d = 0;
+    bool found = false;
+
+    for (; d <= max && !found; ++d) {
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                x = v[offset + k + 1];
+            else
+                x = v[offset + k - 1] + 1;
+
+            int y = x - k;
+            while (x < n && y < m && equal(prefix + x, prefix + y)) {
+                ++x;
+                ++y;
+            }
+
+            v[offset + k] = x;
+
+            if (x >= n && y >= m) {
+                found = true;
+                break;
+            }
+        }
+
+        trace += v.mid(offset - d, 2 * d + 1);
+    }
+
+    if (!found)
+        return false;
+
+    // Walk back from (n, m), each round contributes one insertion or deletion
+    // that starts at (startX, startY).
+    struct Edit { int x; int y; bool insertion; };
+    QVector<Edit> edits;
+    edits.reserve(d);
+
+    int x = n;
+    int y = m;
+    for (int e = d - 1; e > 0; --e) {
+        const int base = (e - 1) * (e - 1) + (e - 1);
+        const int k = x - y;
+
+        const bool insertion = k == -e || (k != e && trace[base + k - 1] < trace[base + k + 1]);
+        const int prevK = insertion ? k + 1 : k - 1;
+        const int prevX = trace[base + prevK];
+        const int prevY = prevX - prevK;
+
+        edits.append({ prevX, prevY, insertion });
+        x = prevX;
+        y = prevY;
+    }
+
+    for (int i = edits.size() - 1; i >= 0; --i) {
+        const Edit &edit = edits.at(i);
+
+        if (!hunks.isEmpty()) {
+            DiffHunk &last = hunks.last();
+            if (last.oldStart + last.oldCount == prefix + edit.x
+                    && last.newStart + last.newCount == prefix + edit.y) {
+                if (edit.insertion)
+                    ++last.newCount;
+                else
+                    ++last.oldCount;
+                continue;
+            }
+        }
+
+        hunks.append({ prefix + edit.x, edit.insertion ? 0 : 1,
+                       prefix + edit.y, edit.insertion ? 1 : 0 });
+    }
+
+    return true;
+}
+
 class BaseModelPrivate;
 class BaseModel : public QAbstractListModel
 {
@@ -35,6 +161,8 @@ protected:
 public:
     enum ModelDataRoles {
         ModelDataRole = Qt::UserRole + 1,
+        // Roles declared with BASEMODEL_FIELDS, in declaration order.
+        FirstFieldRole
     };
     QHash<int, QByteArray> roleNames() const override;
 
@@ -53,17 +181,186 @@ public:
 
 } // namespace Internal
 
+/**
+ * Roles read straight from the fields of T.
+ *
+ * Without a declaration BaseModel<T> only has the modelData role, which
+ * copies the whole T into a QVariant for every binding. A declaration
+ * adds one role per member or const getter, named after it:
+ *
+ *   BASEMODEL_FIELDS(AppItem,
+ *       BASEMODEL_MEMBER(AppItem, name),
+ *       BASEMODEL_GETTER(AppItem, displayName))
+ *
+ * The table is built at compile time and data() indexes it by role, only
+ * the requested field is converted. Use it at global scope, after T and
+ * before the first BaseModel<T> is instantiated.
+ */
+template <typename T>
+struct BaseModelField
+{
+    const char *name;
+    QVariant (*read)(const T &t);
+};
+
+template <typename T>
+struct BaseModelFields
+{
+    static const BaseModelField<T> *fields(int &count)
+    {
+        count = 0;
+        return nullptr;
+    }
+};
+
+namespace Internal {
+
+template <typename T, typename M, M T::*member>
+QVariant readMember(const T &t)
+{
+    return QVariant::fromValue(t.*member);
+}
+
+template <typename T, typename R, R (T::*getter)() const>
+QVariant readGetter(const T &t)
+{
+    return QVariant::fromValue((t.*getter)());
+}
+
+} // namespace Internal
+
+#define BASEMODEL_MEMBER(Class, member) \
+    { #member, &Internal::readMember<Class, decltype(Class::member), &Class::member> }
+
+#define BASEMODEL_GETTER(Class, getter) \
+    { #getter, &Internal::readGetter<Class, decltype(std::declval<const Class &>().getter()), &Class::getter> }
+
+#define BASEMODEL_FIELDS(Class, ...) \
+    template <> \
+    struct BaseModelFields<Class> \
+    { \
+        static const BaseModelField<Class> *fields(int &count) \
+        { \
+            static constexpr BaseModelField<Class> table[] = { __VA_ARGS__ }; \
+            count = int(sizeof(table) / sizeof(table[0])); \
+            return table; \
+        } \
+    };
+
+/**
+ * Contiguous storage for BaseModel, BaseModel<T, BaseModelVector<T> >.
+ *
+ * On Qt 5 QList allocates a node for every T larger than a pointer, so
+ * walking the rows chases one pointer per row. Here the rows live in one
+ * block and are moved, not copied, when rows in front of them come and go.
+ * Provides the part of the QList API BaseModel relies on.
+ */
+template <typename T>
+class BaseModelVector : public std::vector<T>
+{
+    typedef std::vector<T> Base;
+
+public:
+    BaseModelVector() { }
+    BaseModelVector(std::initializer_list<T> l) : Base(l) { }
+    BaseModelVector(const QList<T> &l) : Base(l.begin(), l.end()) { }
+
+    int count() const { return int(Base::size()); }
+    bool isEmpty() const { return Base::empty(); }
+
+    const T &at(int i) const { return Base::operator[](i); }
+    T &operator[](int i) { return Base::operator[](i); }
+    const T &operator[](int i) const { return Base::operator[](i); }
+
+    T &first() { return Base::front(); }
+    const T &first() const { return Base::front(); }
+    T &last() { return Base::back(); }
+    const T &last() const { return Base::back(); }
+
+    T value(int i) const { return value(i, T()); }
+    T value(int i, const T &defaultValue) const
+    { return (i >= 0 && i < count()) ? at(i) : defaultValue; }
+
+    int indexOf(const T &t) const
+    {
+        typename Base::const_iterator it = std::find(Base::begin(), Base::end(), t);
+        return it == Base::end() ? -1 : int(it - Base::begin());
+    }
+    bool contains(const T &t) const { return indexOf(t) != -1; }
+
+    void append(const T &t) { Base::push_back(t); }
+    void append(T &&t) { Base::push_back(std::move(t)); }
+    void append(const BaseModelVector &l) { Base::insert(Base::end(), l.begin(), l.end()); }
+    void prepend(const T &t) { insert(0, t); }
+    void push_front(const T &t) { insert(0, t); }
+
+    using Base::insert;
+    void insert(int i, const T &t) { Base::insert(Base::begin() + i, t); }
+    void insert(int i, T &&t) { Base::insert(Base::begin() + i, std::move(t)); }
+
+    void replace(int i, const T &t) { Base::operator[](i) = t; }
+    void replace(int i, T &&t) { Base::operator[](i) = std::move(t); }
+
+    void removeAt(int i) { Base::erase(Base::begin() + i); }
+    void removeFirst() { removeAt(0); }
+    void removeLast() { Base::pop_back(); }
+    void pop_front() { removeAt(0); }
+
+    T takeAt(int i) { T t(std::move(Base::operator[](i))); removeAt(i); return t; }
+    T takeFirst() { return takeAt(0); }
+    T takeLast() { T t(std::move(Base::back())); Base::pop_back(); return t; }
+
+    using Base::swap;
+    void swap(int i, int j) { std::swap(Base::operator[](i), Base::operator[](j)); }
+
+    void move(int from, int to)
+    {
+        if (from < to)
+            std::rotate(Base::begin() + from, Base::begin() + from + 1, Base::begin() + to + 1);
+        else if (from > to)
+            std::rotate(Base::begin() + to, Base::begin() + from, Base::begin() + from + 1);
+    }
+
+    bool operator==(const BaseModelVector &other) const
+    { return static_cast<const Base &>(*this) == static_cast<const Base &>(other); }
+    bool operator!=(const BaseModelVector &other) const
+    { return !operator==(other); }
+};
+
+namespace Internal {
+
+// Inserts l in front of row i with a single shift of the rows behind it
+// where the storage allows.
+template <typename T>
+void insertRows(QList<T> &list, int i, const QList<T> &l)
+{
+    list.reserve(list.count() + l.count());
+    for (int j = 0; j < l.count(); ++j)
+        list.insert(i + j, l.at(j));
+}
+
 template <typename T>
-class BaseModel : public Internal::BaseModel, public QList<T>
+void insertRows(std::vector<T> &list, int i, const std::vector<T> &l)
+{
+    list.insert(list.begin() + i, l.begin(), l.end());
+}
+
+} // namespace Internal
+
+template <typename T, typename Storage = QList<T> >
+class BaseModel : public Internal::BaseModel, public Storage
 {
 public:
-    BaseModel(const QList<T> &l, QObject *parent = nullptr)
-        : Internal::BaseModel(parent), QList<T>(l) { }
+    BaseModel(const Storage &l, QObject *parent = nullptr)
+        : Internal::BaseModel(parent), Storage(l) { }
     explicit BaseModel(QObject *parent = nullptr)
         : Internal::BaseModel(parent) { }
 
 public:
+    typedef Storage StorageType;
+
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QHash<int, QByteArray> roleNames() const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
 
@@ -75,16 +372,24 @@ public:
     T value(int i, const T &defaultValue) const;
 
 public:
-    void append(const QList<T> &l);
+    void append(const Storage &l);
 
     void prepend(const T &t);
     void append(const T &t);
+    void append(T &&t);
 
     void push_front(const T &t);
     void push_back(const T &t);
 
     void replace(int i, const T &t);
     void insert(int i, const T &t);
+    void insert(int i, T &&t);
+
+    // Range operations, one signal for the whole range. move() puts the
+    // first of the count rows at row to, like move(int, int).
+    void insert(int i, const Storage &l);
+    void remove(int i, int count);
+    void move(int from, int count, int to);
 
     bool removeOne(const T &t);
     int removeAll(const T &t);
@@ -101,17 +406,29 @@ public:
     T takeLast();
 
     void swap(int i, int j);
-    void swap(QList<T> &list);
+    void swap(Storage &list);
     void move(int from, int to);
 
     void clear();
 
+    // Replaces the content with l and reports the difference as row
+    // insertions, removals and data changes instead of a reset, so views
+    // keep their delegates. Rows are matched by T::operator==.
+    void setList(const Storage &l);
+
+    // Same, but rows are matched by key(row), which must be hashable.
+    // Matched rows are moved into place and reported as changed when
+    // T::operator== says they differ. Falls back to the plain diff of the
+    // keys when they are not unique.
+    template <typename KeyFunction>
+    void setList(const Storage &l, KeyFunction key);
+
 public: // Extra methods
     void deleteAll();
 
 public: // Disabled stl methods
-    typedef typename QList<T>::iterator         Iterator;
-    typedef typename QList<T>::reverse_iterator ReverseIterator;
+    typedef typename Storage::iterator         Iterator;
+    typedef typename Storage::reverse_iterator ReverseIterator;
 
     Iterator begin(); // Not Implemented
     Iterator end(); // Not Implemented
@@ -124,54 +441,84 @@ public: // Disabled stl methods
     Iterator erase(Iterator begin, Iterator end); // Not Implemented
 
 public:
-    BaseModel<T> &operator=(const QList<T> &l);
-    inline QList<T> operator+(const QList<T> &others) const
-    { QList<T> l = *this; l.append(others); return l; }
+    BaseModel<T, Storage> &operator=(const Storage &l);
+    inline Storage operator+(const Storage &others) const
+    { Storage l = *this; l.append(others); return l; }
 
-    inline bool operator==(const QList<T> &other) const
-    { return QList<T>::operator==(other); }
-    inline bool operator!=(const QList<T> &other) const
-    { return QList<T>::operator!=(other); }
+    inline bool operator==(const Storage &other) const
+    { return Storage::operator==(other); }
+    inline bool operator!=(const Storage &other) const
+    { return Storage::operator!=(other); }
 
-    inline BaseModel<T> &operator+=(const QList<T> &l)
+    inline BaseModel<T, Storage> &operator+=(const Storage &l)
     { append(l); return *this; }
-    inline BaseModel<T> &operator<<(const QList<T> &l)
+    inline BaseModel<T, Storage> &operator<<(const Storage &l)
     { append(l); return *this; }
 
-    inline BaseModel<T> &operator+=(const T &t)
+    inline BaseModel<T, Storage> &operator+=(const T &t)
     { append(t); return *this; }
-    inline BaseModel<T> &operator<<(const T &t)
+    inline BaseModel<T, Storage> &operator<<(const T &t)
     { append(t); return *this; }
 
 public:
-    inline const QList<T> &ref() const { return *this; }
+    inline const Storage &ref() const { return *this; }
+
+private:
+    // Beyond this many edits the diff costs more than the views save.
+    enum { MaxDiffCost = 1024 };
+
+    void applyHunks(const Storage &l, const QVector<Internal::DiffHunk> &hunks);
+    void updateChangedRows(const Storage &l);
+    void resetList(const Storage &l);
 };
 
-template <typename T>
-int BaseModel<T>::rowCount(const QModelIndex &parent) const
+template <typename T, typename Storage>
+int BaseModel<T, Storage>::rowCount(const QModelIndex &parent) const
 {
-    return parent.isValid() ? 0 : QList<T>::count();
+    return parent.isValid() ? 0 : Storage::count();
 }
 
-template <typename T>
-QVariant BaseModel<T>::data(const QModelIndex &index, int role) const
+template <typename T, typename Storage>
+QHash<int, QByteArray> BaseModel<T, Storage>::roleNames() const
+{
+    QHash<int, QByteArray> names = Internal::BaseModel::roleNames();
+
+    int count;
+    const BaseModelField<T> *fields = BaseModelFields<T>::fields(count);
+    for (int i = 0; i < count; ++i)
+        names.insert(FirstFieldRole + i, fields[i].name);
+
+    return names;
+}
+
+template <typename T, typename Storage>
+QVariant BaseModel<T, Storage>::data(const QModelIndex &index, int role) const
 {
-    if ((ModelDataRole != role)
-            || !index.isValid()
+    if (!index.isValid()
             || (index.model() != this)
-            || (index.row() >= QList<T>::count())) {
+            || (index.row() >= Storage::count())) {
         return QVariant();
     }
 
-    return QVariant::fromValue(QList<T>::at(index.row()));
+    if (role == ModelDataRole)
+        return QVariant::fromValue(Storage::at(index.row()));
+
+    int count;
+    const BaseModelField<T> *fields = BaseModelFields<T>::fields(count);
+    const unsigned field = unsigned(role - FirstFieldRole);
+
+    if (field < unsigned(count))
+        return fields[field].read(Storage::at(index.row()));
+
+    return QVariant();
 }
 
-template<typename T>
-QModelIndex BaseModel<T>::index(int row, int column, const QModelIndex &parent) const
+template<typename T, typename Storage>
+QModelIndex BaseModel<T, Storage>::index(int row, int column, const QModelIndex &parent) const
 {
     if ((row < 0)
             || (column != 0)
-            || (row >= QList<T>::count())
+            || (row >= Storage::count())
             || parent.isValid()) {
         return QModelIndex();
     }
@@ -179,122 +526,197 @@ QModelIndex BaseModel<T>::index(int row, int column, const QModelIndex &parent)
     return createIndex(row, 0);
 }
 
-template<typename T>
-T BaseModel<T>::value(const QModelIndex &index) const
+template<typename T, typename Storage>
+T BaseModel<T, Storage>::value(const QModelIndex &index) const
 {
     BaseModel_ASSERT(index.model() == this);
 
-    return QList<T>::value(index.row());
+    return Storage::value(index.row());
 }
 
-template<typename T>
-T BaseModel<T>::value(const QModelIndex &index, const T &defaultValue) const
+template<typename T, typename Storage>
+T BaseModel<T, Storage>::value(const QModelIndex &index, const T &defaultValue) const
 {
     BaseModel_ASSERT(index.model() == this);
 
-    return QList<T>::value(index.row(), defaultValue);
+    return Storage::value(index.row(), defaultValue);
 }
 
-template<typename T>
-T BaseModel<T>::value(int i) const
+template<typename T, typename Storage>
+T BaseModel<T, Storage>::value(int i) const
 {
-    return QList<T>::value(i);
+    return Storage::value(i);
 }
 
-template<typename T>
-T BaseModel<T>::value(int i, const T &defaultValue) const
+template<typename T, typename Storage>
+T BaseModel<T, Storage>::value(int i, const T &defaultValue) const
 {
-    return QList<T>::value(i, defaultValue);
+    return Storage::value(i, defaultValue);
 }
 
-template <typename T>
-void BaseModel<T>::append(const QList<T> &l)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::append(const Storage &l)
 {
     if (l.isEmpty())
         return;
 
-    int f = QList<T>::count();
+    int f = Storage::count();
     int t = f + l.count() - 1;
     beginInsertRows(QModelIndex(), f, t);
-    QList<T>::append(l);
+    Storage::append(l);
     endInsertRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::prepend(const T &t)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::prepend(const T &t)
 {
     beginInsertRows(QModelIndex(), 0, 0);
-    QList<T>::prepend(t);
+    Storage::prepend(t);
     endInsertRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::append(const T &t)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::append(const T &t)
 {
-    int r = QList<T>::count();
+    int r = Storage::count();
     beginInsertRows(QModelIndex(), r, r);
-    QList<T>::append(t);
+    Storage::append(t);
     endInsertRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::push_front(const T &t)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::append(T &&t)
+{
+    int r = Storage::count();
+    beginInsertRows(QModelIndex(), r, r);
+    Storage::append(std::move(t));
+    endInsertRows();
+    _q_resetCount();
+}
+
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::push_front(const T &t)
 {
     beginInsertRows(QModelIndex(), 0, 0);
-    QList<T>::push_front(t);
+    Storage::push_front(t);
     endInsertRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::push_back(const T &t)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::push_back(const T &t)
 {
-    int r = QList<T>::count();
+    int r = Storage::count();
     beginInsertRows(QModelIndex(), r, r);
-    QList<T>::push_back(t);
+    Storage::push_back(t);
     endInsertRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::replace(int i, const T &t)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::replace(int i, const T &t)
 {
     BaseModel_ASSERT(i >= 0);
-    BaseModel_ASSERT(i < QList<T>::count());
+    BaseModel_ASSERT(i < Storage::count());
 
     QModelIndex x = index(i, 0);
     if (!x.isValid()) {
         return;
     }
 
-    QList<T>::replace(i, t); emit dataChanged(x, x);
+    Storage::replace(i, t); emit dataChanged(x, x);
 }
 
-template <typename T>
-void BaseModel<T>::insert(int i, const T &t)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::insert(int i, const T &t)
 {
     BaseModel_ASSERT(i >= 0);
-    BaseModel_ASSERT(i <= QList<T>::count());
+    BaseModel_ASSERT(i <= Storage::count());
 
     beginInsertRows(QModelIndex(), i, i);
-    QList<T>::insert(i, t);
+    Storage::insert(i, t);
     endInsertRows();
     _q_resetCount();
 }
 
-template <typename T>
-bool BaseModel<T>::removeOne(const T &t)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::insert(int i, T &&t)
+{
+    BaseModel_ASSERT(i >= 0);
+    BaseModel_ASSERT(i <= Storage::count());
+
+    beginInsertRows(QModelIndex(), i, i);
+    Storage::insert(i, std::move(t));
+    endInsertRows();
+    _q_resetCount();
+}
+
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::insert(int i, const Storage &l)
+{
+    BaseModel_ASSERT(i >= 0);
+    BaseModel_ASSERT(i <= Storage::count());
+
+    if (l.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), i, i + l.count() - 1);
+    Internal::insertRows(*this, i, l);
+    endInsertRows();
+    _q_resetCount();
+}
+
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::remove(int i, int count)
+{
+    BaseModel_ASSERT(i >= 0);
+    BaseModel_ASSERT(count >= 0);
+    BaseModel_ASSERT(i + count <= Storage::count());
+
+    if (count <= 0)
+        return;
+
+    beginRemoveRows(QModelIndex(), i, i + count - 1);
+    Storage::erase(Storage::begin() + i, Storage::begin() + i + count);
+    endRemoveRows();
+    _q_resetCount();
+}
+
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::move(int from, int count, int to)
+{
+    BaseModel_ASSERT(from >= 0);
+    BaseModel_ASSERT(to >= 0);
+    BaseModel_ASSERT(from + count <= Storage::count());
+    BaseModel_ASSERT(to + count <= Storage::count());
+
+    if (from == to || count <= 0)
+        return;
+
+    QModelIndex p;
+    const int t = (from < to) ? (to + count) : to;
+    if (beginMoveRows(p, from, from + count - 1, p, t)) {
+        if (from < to)
+            std::rotate(Storage::begin() + from, Storage::begin() + from + count, Storage::begin() + to + count);
+        else
+            std::rotate(Storage::begin() + to, Storage::begin() + from, Storage::begin() + from + count);
+        endMoveRows();
+    }
+}
+
+template <typename T, typename Storage>
+bool BaseModel<T, Storage>::removeOne(const T &t)
 {
-    typename QList<T>::iterator p = QList<T>::begin();
-    typename QList<T>::iterator end = QList<T>::end();
+    typename Storage::iterator p = Storage::begin();
+    typename Storage::iterator end = Storage::end();
 
     for (int i = 0; p != end; ++p, ++i) {
         if (*p == t) {
             beginRemoveRows(QModelIndex(), i, i);
-            QList<T>::erase(p);
+            Storage::erase(p);
             endRemoveRows();
             _q_resetCount();
 
@@ -305,46 +727,26 @@ bool BaseModel<T>::removeOne(const T &t)
     return false;
 }
 
-template <typename T>
-int BaseModel<T>::removeAll(const T &t)
+template <typename T, typename Storage>
+int BaseModel<T, Storage>::removeAll(const T &t)
 {
-    typename QList<T>::iterator null;
-    typename QList<T>::iterator f = null;
-    typename QList<T>::iterator l = null;
-    typename QList<T>::iterator p = QList<T>::begin();
-    typename QList<T>::iterator end = QList<T>::end();
-
+    // One removal per run of equal rows.
     int c = 0;
-    int fpos = 0;
-    int lpos = 0;
-
-    for (int i = 0; p != end; ++p, ++i) {
-        if (t == *p) {
-            if (f == null) {
-                fpos = i;
-                f = p;
-            }
-            lpos = i;
-            l = p;
 
-        } else if (f != null) {
-            beginRemoveRows(QModelIndex(), fpos - c, lpos - c);
-            QList<T>::erase(f, ++l);
-            endRemoveRows();
+    for (int i = Storage::count() - 1; i >= 0; --i) {
+        if (!(Storage::at(i) == t))
+            continue;
 
-            c += lpos - fpos + 1;
+        int first = i;
+        while (first > 0 && Storage::at(first - 1) == t)
+            --first;
 
-            f = null;
-            l = null;
-        }
-    }
-
-    if (f != null) {
-        beginRemoveRows(QModelIndex(), fpos - c, lpos - c);
-        QList<T>::erase(f, ++l);
+        beginRemoveRows(QModelIndex(), first, i);
+        Storage::erase(Storage::begin() + first, Storage::begin() + i + 1);
         endRemoveRows();
 
-        c += lpos - fpos + 1;
+        c += i - first + 1;
+        i = first;
     }
 
     _q_resetCount();
@@ -352,126 +754,130 @@ int BaseModel<T>::removeAll(const T &t)
     return c;
 }
 
-template <typename T>
-void BaseModel<T>::pop_front()
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::pop_front()
 {
-    BaseModel_ASSERT(QList<T>::count() > 0);
+    BaseModel_ASSERT(Storage::count() > 0);
 
     beginRemoveRows(QModelIndex(), 0, 0);
-    QList<T>::pop_front();
+    Storage::pop_front();
     endRemoveRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::pop_back()
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::pop_back()
 {
-    BaseModel_ASSERT(QList<T>::count() > 0);
+    BaseModel_ASSERT(Storage::count() > 0);
 
-    int r = QList<T>::count() - 1;
+    int r = Storage::count() - 1;
     beginRemoveRows(QModelIndex(), r, r);
-    QList<T>::pop_back();
+    Storage::pop_back();
     endRemoveRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::removeAt(int i)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::removeAt(int i)
 {
     BaseModel_ASSERT(i >= 0);
-    BaseModel_ASSERT(i < QList<T>::count());
+    BaseModel_ASSERT(i < Storage::count());
 
     beginRemoveRows(QModelIndex(), i, i);
-    QList<T>::removeAt(i);
+    Storage::removeAt(i);
     endRemoveRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::removeFirst()
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::removeFirst()
 {
-    BaseModel_ASSERT(QList<T>::count() > 0);
+    BaseModel_ASSERT(Storage::count() > 0);
 
     beginRemoveRows(QModelIndex(), 0, 0);
-    QList<T>::removeFirst();
+    Storage::removeFirst();
     endRemoveRows();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::removeLast()
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::removeLast()
 {
-    BaseModel_ASSERT(QList<T>::count() > 0);
+    BaseModel_ASSERT(Storage::count() > 0);
 
-    int r = QList<T>::count() - 1;
+    int r = Storage::count() - 1;
     beginRemoveRows(QModelIndex(), r, r);
-    QList<T>::removeLast();
+    Storage::removeLast();
     endRemoveRows();
     _q_resetCount();
 }
 
-template <typename T>
-T BaseModel<T>::takeAt(int i)
+template <typename T, typename Storage>
+T BaseModel<T, Storage>::takeAt(int i)
 {
     BaseModel_ASSERT(i >= 0);
-    BaseModel_ASSERT(i < QList<T>::count());
+    BaseModel_ASSERT(i < Storage::count());
 
     beginRemoveRows(QModelIndex(), i, i);
-    T t = QList<T>::takeAt(i);
+    T t = Storage::takeAt(i);
     endRemoveRows();
     _q_resetCount();
 
     return t;
 }
 
-template <typename T>
-T BaseModel<T>::takeFirst()
+template <typename T, typename Storage>
+T BaseModel<T, Storage>::takeFirst()
 {
-    BaseModel_ASSERT(QList<T>::count() > 0);
+    BaseModel_ASSERT(Storage::count() > 0);
 
     beginRemoveRows(QModelIndex(), 0, 0);
-    T t = QList<T>::takeFirst();
+    T t = Storage::takeFirst();
     endRemoveRows();
     _q_resetCount();
 
     return t;
 }
 
-template <typename T>
-T BaseModel<T>::takeLast()
+template <typename T, typename Storage>
+T BaseModel<T, Storage>::takeLast()
 {
-    BaseModel_ASSERT(QList<T>::count() > 0);
+    BaseModel_ASSERT(Storage::count() > 0);
 
-    int r = QList<T>::count() - 1;
+    int r = Storage::count() - 1;
     beginRemoveRows(QModelIndex(), r, r);
-    T t = QList<T>::takeLast();
+    T t = Storage::takeLast();
     endRemoveRows();
     _q_resetCount();
 
     return t;
 }
 
-template <typename T>
-void BaseModel<T>::swap(int i, int j)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::swap(int i, int j)
 {
     if (i == j) {
         return;
     }
 
     BaseModel_ASSERT(i >= 0);
-    BaseModel_ASSERT(i < QList<T>::count());
+    BaseModel_ASSERT(i < Storage::count());
 
     BaseModel_ASSERT(j >= 0);
-    BaseModel_ASSERT(j < QList<T>::count());
+    BaseModel_ASSERT(j < Storage::count());
 
-    QList<T>::swap(i, j);
+    // Two moves rather than two dataChanged, so a view of the model never
+    // sees one of the rows changed while the other still looks old.
+    if (i > j)
+        qSwap(i, j);
 
-    QModelIndex ii = index(i, 0); emit dataChanged(ii, ii);
-    QModelIndex ji = index(j, 0); emit dataChanged(ji, ji);
+    move(i, j);
+    if (j - 1 != i)
+        move(j - 1, i);
 }
 
-template <typename T>
-void BaseModel<T>::swap(QList<T> &l)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::swap(Storage &l)
 {
     /*
     if (l.d == this->d) {
@@ -480,75 +886,317 @@ void BaseModel<T>::swap(QList<T> &l)
     */
 
     beginResetModel();
-    QList<T>::swap(l);
+    Storage::swap(l);
     endResetModel();
     _q_resetCount();
 }
 
-template <typename T>
-void BaseModel<T>::move(int from, int to)
+template <typename T, typename Storage>
+void BaseModel<T, Storage>::move(int from, int to)
 {
     if (from == to) {
         return;
     }
 
     BaseModel_ASSERT(from >= 0);
-    BaseModel_ASSERT(from < QList<T>::count());
+    BaseModel_ASSERT(from < Storage::count());
 
     BaseModel_ASSERT(to >= 0);
-    BaseModel_ASSERT(to < QList<T>::count());
+    BaseModel_ASSERT(to < Storage::count());
 
     QModelIndex p;
     int t = (from < to) ? (to + 1) : to;
     if (beginMoveRows(p, from, from, p, t)) {
-        QList<T>::move(from, to);
+        Storage::move(from, to);
         endMoveRows();
     }
 }
 
-template<typename T>
-void BaseModel<T>::clear()
+template<typename T, typename Storage>
+void BaseModel<T, Storage>::clear()
 {
-    if (QList<T>::isEmpty()) {
+    if (Storage::isEmpty()) {
         return;
     }
 
     beginResetModel();
-    QList<T>::clear();
+    Storage::clear();
     endResetModel();
     _q_resetCount();
 }
 
-template<typename T>
-void BaseModel<T>::deleteAll()
+template<typename T, typename Storage>
+void BaseModel<T, Storage>::deleteAll()
 {
-    if (QList<T>::isEmpty()) {
+    if (Storage::isEmpty()) {
         return;
     }
 
     beginResetModel();
     qDeleteAll(ref());
-    QList<T>::clear();
+    Storage::clear();
     endResetModel();
     _q_resetCount();
 }
 
-template<typename T>
-BaseModel<T> &BaseModel<T>::operator=(const QList<T> &l)
+template<typename T, typename Storage>
+BaseModel<T, Storage> &BaseModel<T, Storage>::operator=(const Storage &l)
 {
-    /*
-    if (l.d == this->d) {
-        return *this;
+    setList(l);
+
+    return *this;
+}
+
+template<typename T, typename Storage>
+void BaseModel<T, Storage>::setList(const Storage &l)
+{
+    const Storage &current = *this;
+
+    QVector<Internal::DiffHunk> hunks;
+    const bool diffed = Internal::diffRows(current.count(), l.count(), [&] (int i, int j) {
+        return current.at(i) == l.at(j);
+    }, MaxDiffCost, hunks);
+
+    if (diffed)
+        applyHunks(l, hunks);
+    else
+        resetList(l);
+
+    _q_resetCount();
+}
+
+template<typename T, typename Storage>
+template<typename KeyFunction>
+void BaseModel<T, Storage>::setList(const Storage &l, KeyFunction key)
+{
+    typedef typename std::decay<decltype(key(std::declval<const T &>()))>::type Key;
+
+    const Storage &current = *this;
+    bool unique = true;
+
+    QHash<Key, int> newRows;
+    newRows.reserve(l.count());
+    for (int i = 0; i < l.count() && unique; ++i) {
+        const Key k = key(l.at(i));
+        unique = !newRows.contains(k);
+        newRows.insert(k, i);
+    }
+
+    QHash<Key, int> oldRows;
+    oldRows.reserve(current.count());
+    for (int i = 0; i < current.count() && unique; ++i) {
+        const Key k = key(current.at(i));
+        unique = !oldRows.contains(k);
+        oldRows.insert(k, i);
+    }
+
+    if (!unique) {
+        QVector<Internal::DiffHunk> hunks;
+        const bool diffed = Internal::diffRows(current.count(), l.count(), [&] (int i, int j) {
+            return key(current.at(i)) == key(l.at(j));
+        }, MaxDiffCost, hunks);
+
+        if (diffed) {
+            applyHunks(l, hunks);
+            updateChangedRows(l);
+        } else {
+            resetList(l);
+        }
+
+        _q_resetCount();
+        return;
     }
-    */
 
+    // Removed rows first, from the back so the rows in front stay valid.
+    for (int i = current.count() - 1; i >= 0; --i) {
+        if (newRows.contains(key(current.at(i))))
+            continue;
+
+        int first = i;
+        while (first > 0 && !newRows.contains(key(current.at(first - 1))))
+            --first;
+
+        beginRemoveRows(QModelIndex(), first, i);
+        Storage::erase(Storage::begin() + first, Storage::begin() + i + 1);
+        endRemoveRows();
+
+        i = first;
+    }
+
+    // The rows that are left, in their current order and in the new one.
+    QVector<Key> keys;
+    keys.reserve(current.count());
+    QHash<Key, int> rows;
+    rows.reserve(current.count());
+    for (int i = 0; i < current.count(); ++i) {
+        keys.append(key(current.at(i)));
+        rows.insert(keys.last(), i);
+    }
+
+    QVector<Key> order;
+    QVector<int> sequence;
+    order.reserve(keys.count());
+    sequence.reserve(keys.count());
+    for (const T &t : l) {
+        const Key k = key(t);
+        if (rows.contains(k)) {
+            order.append(k);
+            sequence.append(rows.value(k));
+        }
+    }
+
+    // The longest run of rows already in the right relative order stays,
+    // every other row is moved once.
+    QVector<int> tails;
+    QVector<int> previous(sequence.count(), -1);
+    for (int i = 0; i < sequence.count(); ++i) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), i, [&] (int tail, int value) {
+            return sequence.at(tail) < sequence.at(value);
+        });
+
+        if (it != tails.begin())
+            previous[i] = *(it - 1);
+
+        if (it == tails.end())
+            tails.append(i);
+        else
+            *it = i;
+    }
+
+    QVector<bool> stays(sequence.count(), false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i >= 0; i = previous.at(i))
+        stays[i] = true;
+
+    if (sequence.count() - tails.count() > sequence.count() / 2) {
+        resetList(l);
+        _q_resetCount();
+        return;
+    }
+
+    // Each moved row goes right after the row that precedes it in the new
+    // order, which is in place already. Neighbours that move together are
+    // moved as one block.
+    for (int j = 0; j < order.count(); ) {
+        if (stays.at(j)) {
+            ++j;
+            continue;
+        }
+
+        const int from = rows.value(order.at(j));
+        int count = 1;
+        while (j + count < order.count() && !stays.at(j + count)
+               && from + count < keys.count() && keys.at(from + count) == order.at(j + count))
+            ++count;
+
+        const int to = j > 0 ? rows.value(order.at(j - 1)) + 1 : 0;
+
+        if (to != from && beginMoveRows(QModelIndex(), from, from + count - 1, QModelIndex(), to)) {
+            const int first = qMin(from, to);
+            const int last = qMax(from + count, to);
+
+            if (to < from) {
+                std::rotate(Storage::begin() + to, Storage::begin() + from, Storage::begin() + from + count);
+                std::rotate(keys.begin() + to, keys.begin() + from, keys.begin() + from + count);
+            } else {
+                std::rotate(Storage::begin() + from, Storage::begin() + from + count, Storage::begin() + to);
+                std::rotate(keys.begin() + from, keys.begin() + from + count, keys.begin() + to);
+            }
+
+            // Only the rotated rows changed place, so a lookup stays O(1)
+            // instead of a scan of keys per block.
+            for (int i = first; i < last; ++i)
+                rows[keys.at(i)] = i;
+
+            endMoveRows();
+        }
+
+        j += count;
+    }
+
+    // Everything in front of row i matches l now, new rows fill the gaps.
+    for (int i = 0; i < l.count(); ++i) {
+        if (oldRows.contains(key(l.at(i))))
+            continue;
+
+        int last = i;
+        while (last + 1 < l.count() && !oldRows.contains(key(l.at(last + 1))))
+            ++last;
+
+        beginInsertRows(QModelIndex(), i, last);
+        for (int j = i; j <= last; ++j)
+            Storage::insert(j, l.at(j));
+        endInsertRows();
+
+        i = last;
+    }
+
+    updateChangedRows(l);
+    _q_resetCount();
+}
+
+template<typename T, typename Storage>
+void BaseModel<T, Storage>::applyHunks(const Storage &l, const QVector<Internal::DiffHunk> &hunks)
+{
+    // From the back, so the old rows of the hunks in front stay valid. Rows
+    // replaced one by one are reported as changed.
+    for (int h = hunks.count() - 1; h >= 0; --h) {
+        const Internal::DiffHunk &hunk = hunks.at(h);
+        const int replaced = qMin(hunk.oldCount, hunk.newCount);
+
+        if (replaced > 0) {
+            for (int i = 0; i < replaced; ++i)
+                Storage::replace(hunk.oldStart + i, l.at(hunk.newStart + i));
+
+            emit dataChanged(index(hunk.oldStart, 0), index(hunk.oldStart + replaced - 1, 0));
+        }
+
+        if (hunk.oldCount > replaced) {
+            const int first = hunk.oldStart + replaced;
+            const int last = hunk.oldStart + hunk.oldCount - 1;
+
+            beginRemoveRows(QModelIndex(), first, last);
+            Storage::erase(Storage::begin() + first, Storage::begin() + last + 1);
+            endRemoveRows();
+        }
+
+        if (hunk.newCount > replaced) {
+            const int first = hunk.oldStart + replaced;
+            const int count = hunk.newCount - replaced;
+
+            beginInsertRows(QModelIndex(), first, first + count - 1);
+            for (int i = 0; i < count; ++i)
+                Storage::insert(first + i, l.at(hunk.newStart + replaced + i));
+            endInsertRows();
+        }
+    }
+}
+
+template<typename T, typename Storage>
+void BaseModel<T, Storage>::updateChangedRows(const Storage &l)
+{
+    for (int i = 0; i < l.count(); ++i) {
+        if (Storage::at(i) == l.at(i))
+            continue;
+
+        int last = i;
+        Storage::replace(i, l.at(i));
+        while (last + 1 < l.count() && !(Storage::at(last + 1) == l.at(last + 1))) {
+            ++last;
+            Storage::replace(last, l.at(last));
+        }
+
+        emit dataChanged(index(i, 0), index(last, 0));
+        i = last;
+    }
+}
+
+template<typename T, typename Storage>
+void BaseModel<T, Storage>::resetList(const Storage &l)
+{
     beginResetModel();
-    QList<T> tmp(l);
+    Storage tmp(l);
     tmp.swap(*this);
     endResetModel();
-    _q_resetCount();
-
-    return *this;
 }
 
 #endif // BASEMODEL_H
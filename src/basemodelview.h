@@ -0,0 +1,414 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BASEMODELVIEW_H
+#define BASEMODELVIEW_H
+
+#include "basemodel.h"
+
+#include <QAbstractListModel>
+#include <QVector>
+
+#include <algorithm>
+#include <functional>
+
+// Predicate for views that only sort.
+struct BaseModelAcceptAll
+{
+    template <typename T>
+    bool operator()(const T &) const { return true; }
+};
+
+// Comparator for views that only filter, rows keep the source order.
+struct BaseModelSourceOrder
+{
+    template <typename T>
+    bool operator()(const T &, const T &) const { return false; }
+};
+
+/**
+ * A sorted and filtered view of a BaseModel<T>, kept up to date
+ * incrementally instead of sorting again on every change like
+ * QSortFilterProxyModel.
+ *
+ * Predicate (bool(const T &)) and LessThan (bool(const T &, const T &))
+ * are types, so both calls are inlined. Rows that compare equal keep
+ * their source order.
+ *
+ * Every source row is kept in one sorted index, the accepted rows are a
+ * subsequence of it. Source insertions and data changes place rows by
+ * binary search, and setPredicate() filters the sorted index again in
+ * O(n) and reports the difference as runs of removed and inserted rows.
+ * That makes it cheap to change the search text on every keystroke:
+ *
+ *   struct NameContains {
+ *       QString text;
+ *       bool operator()(const AppItem &item) const { return item.name.contains(text, Qt::CaseInsensitive); }
+ *   };
+ *   BaseModelView<AppItem, NameContains, ByName> view(&model);
+ *   view.setPredicate(NameContains { text });
+ *
+ * Moves and layout changes of the source are rare for sorted data and
+ * reset the view.
+ */
+template <typename T, typename Predicate = BaseModelAcceptAll, typename LessThan = std::less<T>,
+          typename Storage = QList<T> >
+class BaseModelView : public QAbstractListModel
+{
+public:
+    typedef BaseModel<T, Storage> SourceModel;
+
+    explicit BaseModelView(SourceModel *source,
+                           const Predicate &predicate = Predicate(),
+                           const LessThan &lessThan = LessThan(),
+                           QObject *parent = nullptr);
+
+    SourceModel *sourceModel() const { return m_source; }
+
+    const Predicate &predicate() const { return m_predicate; }
+    void setPredicate(const Predicate &predicate);
+
+    int mapToSource(int row) const { return m_rows.value(row, -1); }
+    int mapFromSource(int sourceRow) const { return m_rows.indexOf(sourceRow); }
+
+    const T &at(int row) const { return m_source->at(m_rows.at(row)); }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    bool lessRow(int a, int b) const;
+    int lowerBound(const QVector<int> &rows, int sourceRow) const;
+
+    void sortRows();
+    void insertRow(int sourceRow);
+    void placeRows(int first, int last);
+    void updateRow(int sourceRow);
+
+    void onRowsInserted(int first, int last);
+    void onRowsAboutToBeRemoved(int first, int last);
+    void onRowsRemoved(int first, int last);
+    void onDataChanged(int first, int last);
+
+private:
+    SourceModel *m_source;
+    Predicate m_predicate;
+    LessThan m_lessThan;
+
+    // Every source row in sorted order, and the accepted ones.
+    QVector<int> m_sorted;
+    QVector<int> m_rows;
+};
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+BaseModelView<T, Predicate, LessThan, Storage>::BaseModelView(SourceModel *source,
+                                                              const Predicate &predicate,
+                                                              const LessThan &lessThan,
+                                                              QObject *parent)
+    : QAbstractListModel(parent)
+    , m_source(source)
+    , m_predicate(predicate)
+    , m_lessThan(lessThan)
+{
+    sortRows();
+
+    connect(source, &QAbstractItemModel::rowsInserted, this, [this] (const QModelIndex &, int first, int last) {
+        onRowsInserted(first, last);
+    });
+    connect(source, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this] (const QModelIndex &, int first, int last) {
+        onRowsAboutToBeRemoved(first, last);
+    });
+    connect(source, &QAbstractItemModel::rowsRemoved, this, [this] (const QModelIndex &, int first, int last) {
+        onRowsRemoved(first, last);
+    });
+    connect(source, &QAbstractItemModel::dataChanged, this, [this] (const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+        onDataChanged(topLeft.row(), bottomRight.row());
+    });
+
+    // Everything that reorders the source starts over.
+    connect(source, &QAbstractItemModel::modelAboutToBeReset, this, [this] { beginResetModel(); });
+    connect(source, &QAbstractItemModel::modelReset, this, [this] { sortRows(); endResetModel(); });
+    connect(source, &QAbstractItemModel::rowsAboutToBeMoved, this, [this] { beginResetModel(); });
+    connect(source, &QAbstractItemModel::rowsMoved, this, [this] { sortRows(); endResetModel(); });
+    connect(source, &QAbstractItemModel::layoutAboutToBeChanged, this, [this] { beginResetModel(); });
+    connect(source, &QAbstractItemModel::layoutChanged, this, [this] { sortRows(); endResetModel(); });
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::setPredicate(const Predicate &predicate)
+{
+    m_predicate = predicate;
+
+    QVector<int> rows;
+    rows.reserve(m_sorted.size());
+    for (int row : qAsConst(m_sorted)) {
+        if (m_predicate(m_source->at(row)))
+            rows.append(row);
+    }
+
+    // Both lists are subsequences of m_sorted, walk it once and turn the
+    // difference into runs. Pending removals start at position, pending
+    // insertions go in front of it.
+    int position = 0;
+    int removals = 0;
+    QVector<int> insertions;
+    int next = 0;
+
+    auto flush = [&] {
+        if (removals > 0) {
+            beginRemoveRows(QModelIndex(), position, position + removals - 1);
+            m_rows.erase(m_rows.begin() + position, m_rows.begin() + position + removals);
+            endRemoveRows();
+            removals = 0;
+        }
+
+        if (!insertions.isEmpty()) {
+            beginInsertRows(QModelIndex(), position, position + insertions.size() - 1);
+            for (int i = 0; i < insertions.size(); ++i)
+                m_rows.insert(position + i, insertions.at(i));
+            endInsertRows();
+            position += insertions.size();
+            insertions.clear();
+        }
+    };
+
+    for (int row : qAsConst(m_sorted)) {
+        const int current = position + removals;
+        const bool wasAccepted = current < m_rows.size() && m_rows.at(current) == row;
+        const bool accepted = next < rows.size() && rows.at(next) == row;
+
+        if (accepted)
+            ++next;
+
+        if (wasAccepted && accepted) {
+            flush();
+            ++position;
+        } else if (wasAccepted) {
+            if (!insertions.isEmpty())
+                flush();
+            ++removals;
+        } else if (accepted) {
+            if (removals > 0)
+                flush();
+            insertions.append(row);
+        }
+    }
+
+    flush();
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+int BaseModelView<T, Predicate, LessThan, Storage>::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+QHash<int, QByteArray> BaseModelView<T, Predicate, LessThan, Storage>::roleNames() const
+{
+    return m_source->roleNames();
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+QVariant BaseModelView<T, Predicate, LessThan, Storage>::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size())
+        return QVariant();
+
+    return m_source->data(m_source->index(m_rows.at(index.row()), 0), role);
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+bool BaseModelView<T, Predicate, LessThan, Storage>::lessRow(int a, int b) const
+{
+    const T &left = m_source->at(a);
+    const T &right = m_source->at(b);
+
+    if (m_lessThan(left, right))
+        return true;
+    if (m_lessThan(right, left))
+        return false;
+
+    return a < b;
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+int BaseModelView<T, Predicate, LessThan, Storage>::lowerBound(const QVector<int> &rows, int sourceRow) const
+{
+    auto it = std::lower_bound(rows.begin(), rows.end(), sourceRow, [this] (int a, int b) {
+        return lessRow(a, b);
+    });
+
+    return int(it - rows.begin());
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::sortRows()
+{
+    const int count = m_source->rowCount();
+
+    m_sorted.resize(count);
+    for (int i = 0; i < count; ++i)
+        m_sorted[i] = i;
+
+    std::sort(m_sorted.begin(), m_sorted.end(), [this] (int a, int b) {
+        return lessRow(a, b);
+    });
+
+    m_rows.clear();
+    for (int row : qAsConst(m_sorted)) {
+        if (m_predicate(m_source->at(row)))
+            m_rows.append(row);
+    }
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::insertRow(int sourceRow)
+{
+    const int position = lowerBound(m_rows, sourceRow);
+
+    beginInsertRows(QModelIndex(), position, position);
+    m_rows.insert(position, sourceRow);
+    endInsertRows();
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::placeRows(int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        m_sorted.insert(lowerBound(m_sorted, row), row);
+
+        if (m_predicate(m_source->at(row)))
+            insertRow(row);
+    }
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::updateRow(int sourceRow)
+{
+    m_sorted.remove(m_sorted.indexOf(sourceRow));
+    m_sorted.insert(lowerBound(m_sorted, sourceRow), sourceRow);
+
+    const int from = m_rows.indexOf(sourceRow);
+    const bool accepted = m_predicate(m_source->at(sourceRow));
+
+    if (from == -1) {
+        if (accepted)
+            insertRow(sourceRow);
+        return;
+    }
+
+    if (!accepted) {
+        beginRemoveRows(QModelIndex(), from, from);
+        m_rows.remove(from);
+        endRemoveRows();
+        return;
+    }
+
+    m_rows.remove(from);
+    const int to = lowerBound(m_rows, sourceRow);
+
+    if (to != from) {
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+        m_rows.insert(to, sourceRow);
+        endMoveRows();
+    } else {
+        m_rows.insert(to, sourceRow);
+    }
+
+    emit dataChanged(index(to, 0), index(to, 0));
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::onRowsInserted(int first, int last)
+{
+    const int count = last - first + 1;
+
+    for (int &row : m_sorted) {
+        if (row >= first)
+            row += count;
+    }
+    for (int &row : m_rows) {
+        if (row >= first)
+            row += count;
+    }
+
+    placeRows(first, last);
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::onRowsAboutToBeRemoved(int first, int last)
+{
+    // Runs of rows that sort next to each other go in one signal.
+    for (int i = m_rows.size() - 1; i >= 0; --i) {
+        if (m_rows.at(i) < first || m_rows.at(i) > last)
+            continue;
+
+        int begin = i;
+        while (begin > 0 && m_rows.at(begin - 1) >= first && m_rows.at(begin - 1) <= last)
+            --begin;
+
+        beginRemoveRows(QModelIndex(), begin, i);
+        m_rows.erase(m_rows.begin() + begin, m_rows.begin() + i + 1);
+        endRemoveRows();
+
+        i = begin;
+    }
+
+    m_sorted.erase(std::remove_if(m_sorted.begin(), m_sorted.end(), [=] (int row) {
+        return row >= first && row <= last;
+    }), m_sorted.end());
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::onRowsRemoved(int first, int last)
+{
+    const int count = last - first + 1;
+
+    for (int &row : m_sorted) {
+        if (row > last)
+            row -= count;
+    }
+    for (int &row : m_rows) {
+        if (row > last)
+            row -= count;
+    }
+}
+
+template <typename T, typename Predicate, typename LessThan, typename Storage>
+void BaseModelView<T, Predicate, LessThan, Storage>::onDataChanged(int first, int last)
+{
+    if (first == last) {
+        updateRow(first);
+        return;
+    }
+
+    // The other changed rows would be out of place while one of them is
+    // searched for, take them all out and put back the accepted ones.
+    onRowsAboutToBeRemoved(first, last);
+
+    placeRows(first, last);
+}
+
+template <typename T, typename Predicate, typename Storage = QList<T> >
+using BaseModelFilterView = BaseModelView<T, Predicate, BaseModelSourceOrder, Storage>;
+
+template <typename T, typename LessThan, typename Storage = QList<T> >
+using BaseModelSortView = BaseModelView<T, BaseModelAcceptAll, LessThan, Storage>;
+
+#endif // BASEMODELVIEW_H
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "blurredwallpaper.h"
+#include "boxblur.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QCryptographicHash>
+#include <QGuiApplication>
+#include <QStandardPaths>
+#include <QImageReader>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QRect>
+#include <QDir>
+
+static QString cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/wallpaper");
+}
+
+BlurredWallpaper::BlurredWallpaper(QObject *parent)
+    : QObject(parent)
+    , m_radius(0)
+{
+    // Properties are usually set one after another, render once.
+    m_updateTimer.setInterval(0);
+    m_updateTimer.setSingleShot(true);
+    connect(&m_updateTimer, &QTimer::timeout, this, &BlurredWallpaper::update);
+
+    connect(&m_watcher, &QFutureWatcher<QString>::finished, this, [=] {
+        // Ignore renders of a wallpaper that is no longer current.
+        if (m_watcher.future().resultCount() > 0 && m_watcher.result() == m_fileName)
+            setUrl(QUrl::fromLocalFile(m_fileName));
+    });
+}
+
+QString BlurredWallpaper::source() const
+{
+    return m_source;
+}
+
+void BlurredWallpaper::setSource(const QString &source)
+{
+    if (m_source != source) {
+        m_source = source;
+        m_updateTimer.start();
+        emit sourceChanged();
+    }
+}
+
+QSize BlurredWallpaper::size() const
+{
+    return m_size;
+}
+
+void BlurredWallpaper::setSize(const QSize &size)
+{
+    if (m_size != size) {
+        m_size = size;
+        m_updateTimer.start();
+        emit sizeChanged();
+    }
+}
+
+int BlurredWallpaper::radius() const
+{
+    return m_radius;
+}
+
+void BlurredWallpaper::setRadius(int radius)
+{
+    if (m_radius != radius) {
+        m_radius = radius;
+        m_updateTimer.start();
+        emit radiusChanged();
+    }
+}
+
+QUrl BlurredWallpaper::url() const
+{
+    return m_url;
+}
+
+void BlurredWallpaper::update()
+{
+    QFileInfo info(m_source);
+
+    if (!info.exists() || m_size.isEmpty()) {
+        m_fileName.clear();
+        setUrl(QUrl());
+        return;
+    }
+
+    const qreal dpr = qApp->devicePixelRatio();
+    const QSize size = m_size * dpr;
+    const int radius = qRound(m_radius * dpr);
+
+    const QByteArray key = QStringLiteral("%1:%2:%3x%4:%5")
+            .arg(info.absoluteFilePath())
+            .arg(info.lastModified().toMSecsSinceEpoch())
+            .arg(size.width()).arg(size.height())
+            .arg(radius).toUtf8();
+    m_fileName = cacheDirectory() + '/'
+            + QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex() + QStringLiteral(".jpg");
+
+    if (QFile::exists(m_fileName)) {
+        setUrl(QUrl::fromLocalFile(m_fileName));
+        return;
+    }
+
+    m_watcher.setFuture(QtConcurrent::run(BlurredWallpaper::render, m_source, size, radius, m_fileName));
+}
+
+void BlurredWallpaper::setUrl(const QUrl &url)
+{
+    if (m_url != url) {
+        m_url = url;
+        emit urlChanged();
+    }
+}
+
+QString BlurredWallpaper::render(const QString &source, const QSize &size, int radius, const QString &fileName)
+{
+    // Let the decoder scale (JPEG does it while decoding) and crop to the
+    // screen like Image.PreserveAspectCrop.
+    QImageReader reader(source);
+    reader.setAutoTransform(true);
+
+    const QSize imageSize = reader.size();
+    if (imageSize.isValid()) {
+        const QSize scaled = imageSize.scaled(size, Qt::KeepAspectRatioByExpanding);
+        reader.setScaledSize(scaled);
+        reader.setScaledClipRect(QRect((scaled.width() - size.width()) / 2,
+                                       (scaled.height() - size.height()) / 2,
+                                       size.width(), size.height()));
+    }
+
+    QImage image = reader.read();
+    if (image.isNull())
+        return QString();
+
+    if (image.size() != size) {
+        image = image.scaled(size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        image = image.copy((image.width() - size.width()) / 2,
+                           (image.height() - size.height()) / 2,
+                           size.width(), size.height());
+    }
+
+    image = BoxBlur::blurred(image, radius);
+
+    QDir().mkpath(cacheDirectory());
+
+    // Only the current wallpaper is worth keeping.
+    QDirIterator it(cacheDirectory(), { QStringLiteral("*.jpg") }, QDir::Files);
+    while (it.hasNext()) {
+        const QString old = it.next();
+        if (old != fileName)
+            QFile::remove(old);
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)
+            || !image.convertToFormat(QImage::Format_RGB32).save(&file, "JPG", 90)
+            || !file.commit()) {
+        return QString();
+    }
+
+    return fileName;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLURREDWALLPAPER_H
+#define BLURREDWALLPAPER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QSize>
+#include <QTimer>
+#include <QUrl>
+
+/**
+ * Provides the blurred wallpaper as a plain image file.
+ *
+ * The wallpaper is decoded at screen size and blurred once on a worker
+ * thread, the result is cached on disk per wallpaper, size and radius so
+ * QML only has to show an image instead of blurring every frame.
+ */
+class BlurredWallpaper : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QSize size READ size WRITE setSize NOTIFY sizeChanged)
+    Q_PROPERTY(int radius READ radius WRITE setRadius NOTIFY radiusChanged)
+    Q_PROPERTY(QUrl url READ url NOTIFY urlChanged)
+
+public:
+    explicit BlurredWallpaper(QObject *parent = nullptr);
+
+    QString source() const;
+    void setSource(const QString &source);
+
+    QSize size() const;
+    void setSize(const QSize &size);
+
+    int radius() const;
+    void setRadius(int radius);
+
+    QUrl url() const;
+
+signals:
+    void sourceChanged();
+    void sizeChanged();
+    void radiusChanged();
+    void urlChanged();
+
+private:
+    static QString render(const QString &source, const QSize &size, int radius, const QString &fileName);
+
+    void update();
+    void setUrl(const QUrl &url);
+
+private:
+    QString m_source;
+    QSize m_size;
+    int m_radius;
+    QUrl m_url;
+    QString m_fileName;
+
+    QTimer m_updateTimer;
+    QFutureWatcher<QString> m_watcher;
+};
+
+#endif // BLURREDWALLPAPER_H
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "boxblur.h"
+
+#include <QVector>
+#include <QtMath>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace BoxBlur {
+
+// Blurs one contiguous line of pixels into dst, which may be a column of
+// the image (dstStride in pixels). Edges are clamped.
+static void blurLine(const quint32 *src, quint32 *dst, int count, int dstStride, int radius)
+{
+    const int window = radius * 2 + 1;
+    const int last = count - 1;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(1.0f / window);
+
+    auto unpack = [&zero] (quint32 pixel) {
+        __m128i v = _mm_cvtsi32_si128(int(pixel));
+        v = _mm_unpacklo_epi8(v, zero);
+        return _mm_unpacklo_epi16(v, zero);
+    };
+
+    __m128i sum = zero;
+    for (int i = -radius; i <= radius; ++i)
+        sum = _mm_add_epi32(sum, unpack(src[qBound(0, i, last)]));
+
+    for (int i = 0; i < count; ++i) {
+        __m128i v = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(sum), scale));
+        v = _mm_packs_epi32(v, v);
+        v = _mm_packus_epi16(v, v);
+        dst[i * dstStride] = quint32(_mm_cvtsi128_si32(v));
+
+        sum = _mm_add_epi32(sum, unpack(src[qMin(i + radius + 1, last)]));
+        sum = _mm_sub_epi32(sum, unpack(src[qMax(i - radius, 0)]));
+    }
+#else
+    quint32 sum[4] = { 0, 0, 0, 0 };
+
+    for (int i = -radius; i <= radius; ++i) {
+        const quint32 pixel = src[qBound(0, i, last)];
+        for (int c = 0; c < 4; ++c)
+            sum[c] += (pixel >> (c * 8)) & 0xff;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        quint32 pixel = 0;
+        for (int c = 0; c < 4; ++c)
+            pixel |= ((sum[c] + window / 2) / window) << (c * 8);
+        dst[i * dstStride] = pixel;
+
+        const quint32 in = src[qMin(i + radius + 1, last)];
+        const quint32 out = src[qMax(i - radius, 0)];
+        for (int c = 0; c < 4; ++c)
+            sum[c] += ((in >> (c * 8)) & 0xff) - ((out >> (c * 8)) & 0xff);
+    }
+#endif
+}
+
+void blur(QImage &image, int radius, int passes)
+{
+    if (image.isNull() || radius < 1)
+        return;
+
+    if (image.depth() != 32)
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    const int width = image.width();
+    const int height = image.height();
+    const int stride = image.bytesPerLine() / 4;
+    quint32 *bits = reinterpret_cast<quint32 *>(image.bits());
+
+    QVector<quint32> lineBuffer(qMax(width, height));
+    quint32 *line = lineBuffer.data();
+
+    for (int pass = 0; pass < passes; ++pass) {
+        for (int y = 0; y < height; ++y) {
+            quint32 *row = bits + y * stride;
+            std::copy(row, row + width, line);
+            blurLine(line, row, width, 1, radius);
+        }
+
+        for (int x = 0; x < width; ++x) {
+            quint32 *column = bits + x;
+            for (int y = 0; y < height; ++y)
+                line[y] = column[y * stride];
+            blurLine(line, column, height, stride, radius);
+        }
+    }
+}
+
+QImage blurred(const QImage &image, int radius)
+{
+    if (image.isNull() || radius < 1)
+        return image;
+
+    // Three box passes of radius r are close to a gaussian with sigma r,
+    // blurring at a quarter of the size costs 1/16 and looks the same.
+    const qreal sigma = radius / 2.0;
+    const int factor = radius >= 16 ? 4 : 1;
+
+    QImage small = image.scaled(qMax(1, image.width() / factor),
+                                qMax(1, image.height() / factor),
+                                Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                        .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    blur(small, qMax(1, qRound(sigma / factor)));
+
+    return small.scaled(image.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+}
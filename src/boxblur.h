@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOXBLUR_H
+#define BOXBLUR_H
+
+#include <QImage>
+
+namespace BoxBlur {
+
+// Separable box blur of a 32 bit image, repeated passes approximate a
+// gaussian. The four channels of a pixel are summed in one SSE2 register.
+void blur(QImage &image, int radius, int passes = 3);
+
+// Gaussian-like blur of the given radius as done by FastBlur: the image is
+// blurred at a fraction of its size and scaled back.
+QImage blurred(const QImage &image, int radius);
+
+}
+
+#endif // BOXBLUR_H
@@ -1,4 +1,5 @@
 #include "desktopproperties.h"
+#include "trace.h"
 #include <QTextStream>
 #include <QStringList>
 #include <QFile>
@@ -11,60 +12,218 @@ DesktopProperties::DesktopProperties(const QString &fileName, const QString &gro
     }
 }
 
+DesktopProperties::DesktopProperties(const QString &fileName, const QString &group, const QStringList &locales)
+    : locales(locales)
+{
+    if (!fileName.isEmpty()) {
+        load(fileName, group);
+    }
+}
+
 DesktopProperties::~DesktopProperties()
 {
 }
 
 bool DesktopProperties::load(const QString &fileName, const QString &group)
 {
+    TRACE_SPAN("DesktopProperties::load");
+
     // NOTE: This class is used for reading of property files instead of QSettings
     // class, which considers separator ';' as comment
 
     // Try open file
     QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         return false;
     }
 
     // Clear old data
     data.clear();
+    offsets.clear();
+    localizedData.clear();
 
     // Indicator whether group was found or not, if name of group was not
     // specified, groupFound is always true
     bool groupFound = group.isEmpty();
 
-    // Read propeties
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-
-        // Read new line
-        QString line = in.readLine();
+    // Read propeties, lines of other groups are not decoded
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
 
-        // Skip empty line or line with invalid format
-        if (line.trimmed().isEmpty()) {
+        // Skip empty line
+        if (line.isEmpty()) {
             continue;
         }
 
-        // Read group
+        // Read group, only its offset if it is not the one asked for so
+        // loadGroup() can read it later
         // NOTE: symbols '[' and ']' can be found not only in group names, but
         // only group can start with '['
-        if (!group.isEmpty() && line.trimmed().startsWith("[")) {
-            QString tmp = line.trimmed().replace("[", "").replace("]", "");
-            groupFound = group.trimmed().compare(tmp) == 0;
+        if (line.startsWith('[')) {
+            const QString name = QString::fromUtf8(line.mid(1, line.lastIndexOf(']') - 1)).trimmed();
+            offsets.insert(name, file.pos());
+
+            if (!group.isEmpty()) {
+                groupFound = group.trimmed() == name;
+            }
+            continue;
         }
 
-        // If we are in correct group and line contains assignment then read data
-        int first_equal = line.indexOf('=');
+        if (groupFound) {
+            insert(line);
+        }
+    }
+    file.close();
+
+    return true;
+}
+
+bool DesktopProperties::loadGroup(const QString &fileName, qint64 offset)
+{
+    TRACE_SPAN("DesktopProperties::loadGroup");
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(offset)) {
+        return false;
+    }
+
+    data.clear();
+    localizedData.clear();
+
+    // Up to the next group
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
 
-        if (groupFound && first_equal >= 0) {
-            data.insert(line.left(first_equal).trimmed(), line.mid(first_equal + 1).trimmed());
+        if (line.startsWith('[')) {
+            break;
         }
+
+        insert(line);
     }
     file.close();
 
     return true;
 }
 
+qint64 DesktopProperties::groupOffset(const QString &group) const
+{
+    return offsets.value(group, -1);
+}
+
+void DesktopProperties::insert(const QByteArray &line)
+{
+    // If line contains assignment then read data
+    const int first_equal = line.indexOf('=');
+
+    if (first_equal < 0) {
+        return;
+    }
+
+    const QByteArray key = line.left(first_equal).trimmed();
+    const QString value = QString::fromUtf8(line.mid(first_equal + 1).trimmed());
+    data.insert(QString::fromUtf8(key), value);
+
+    // Keep the translation that comes first in locales
+    const int bracket = key.indexOf('[');
+    if (bracket <= 0 || !key.endsWith(']') || locales.isEmpty()) {
+        return;
+    }
+
+    const int rank = locales.indexOf(QString::fromUtf8(key.mid(bracket + 1, key.size() - bracket - 2)));
+    if (rank < 0) {
+        return;
+    }
+
+    const QString name = QString::fromUtf8(key.left(bracket));
+    auto it = localizedData.find(name);
+    if (it == localizedData.end() || rank < it.value().first) {
+        localizedData.insert(name, qMakePair(rank, value));
+    }
+}
+
+void DesktopProperties::setLocales(const QStringList &locales)
+{
+    this->locales = locales;
+}
+
+QString DesktopProperties::localizedValue(const QString &key)
+{
+    auto it = localizedData.constFind(key);
+    if (it != localizedData.constEnd()) {
+        return it.value().second;
+    }
+
+    return data.value(key).toString();
+}
+
+QMap<QString, QString> DesktopProperties::translations(const QString &key) const
+{
+    QMap<QString, QString> result;
+
+    if (data.contains(key)) {
+        result.insert(key, data.value(key).toString());
+    }
+
+    // Translations sort right after "key["
+    const QString prefix = key + QLatin1Char('[');
+    for (auto it = data.lowerBound(prefix); it != data.constEnd() && it.key().startsWith(prefix); ++it) {
+        result.insert(it.key(), it.value().toString());
+    }
+
+    return result;
+}
+
+QStringList DesktopProperties::localeChain(const QString &locale)
+{
+    QString name = locale;
+    QString modifier;
+
+    const int at = name.indexOf(QLatin1Char('@'));
+    if (at >= 0) {
+        modifier = name.mid(at + 1);
+        name.truncate(at);
+    }
+
+    const int dot = name.indexOf(QLatin1Char('.'));
+    if (dot >= 0) {
+        name.truncate(dot);
+    }
+
+    const int underscore = name.indexOf(QLatin1Char('_'));
+    const QString language = underscore >= 0 ? name.left(underscore) : name;
+
+    QStringList chain;
+    if (language.isEmpty() || language == QLatin1String("C") || language == QLatin1String("POSIX")) {
+        return chain;
+    }
+
+    if (underscore >= 0 && !modifier.isEmpty()) {
+        chain << name + QLatin1Char('@') + modifier;
+    }
+    if (underscore >= 0) {
+        chain << name;
+    }
+    if (!modifier.isEmpty()) {
+        chain << language + QLatin1Char('@') + modifier;
+    }
+    chain << language;
+
+    return chain;
+}
+
+QString DesktopProperties::localized(const QMap<QString, QString> &translations, const QString &key,
+                                     const QStringList &locales)
+{
+    for (const QString &locale : locales) {
+        auto it = translations.constFind(key + QLatin1Char('[') + locale + QLatin1Char(']'));
+        if (it != translations.constEnd()) {
+            return it.value();
+        }
+    }
+
+    return translations.value(key);
+}
+
 bool DesktopProperties::save(const QString &fileName, const QString &group)
 {
     // Try open file
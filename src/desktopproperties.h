@@ -4,6 +4,9 @@
 #include <QObject>
 #include <QVariant>
 #include <QMap>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
 
 /**
  * @class DesktopProperties
@@ -16,17 +19,45 @@ class DesktopProperties
 {
 public:
     DesktopProperties(const QString &fileName = "", const QString &group = "");
+    DesktopProperties(const QString &fileName, const QString &group, const QStringList &locales);
     ~DesktopProperties();
 
     QVariant value(const QString &key, const QVariant &defaultValue = QVariant());
     bool load(const QString &fileName, const QString &group = "");
+    // Reads the group that starts at offset, see groupOffset().
+    bool loadGroup(const QString &fileName, qint64 offset);
     bool save(const QString &fileName, const QString &group = "");
     void set(const QString &key, const QVariant &value);
     bool contains(const QString &key) const;
     QStringList allKeys() const;
 
+    // Locales for localizedValue(), best first, see localeChain(). Set
+    // before loading, the best translation is picked while reading.
+    void setLocales(const QStringList &locales);
+    QString localizedValue(const QString &key);
+
+    // The key and all its translations ("Name", "Name[de]", ...).
+    QMap<QString, QString> translations(const QString &key) const;
+
+    // ll_CC.ENCODING@MODIFIER to ll_CC@MODIFIER, ll_CC, ll@MODIFIER, ll.
+    static QStringList localeChain(const QString &locale);
+    // The same pick as localizedValue(), from saved translations.
+    static QString localized(const QMap<QString, QString> &translations, const QString &key,
+                             const QStringList &locales);
+
+    // Where the keys of a group start in the file of the last load(),
+    // or -1. Only one group is read, the others are found by this.
+    qint64 groupOffset(const QString &group) const;
+
+protected:
+    void insert(const QByteArray &line);
+
 protected:
     QMap<QString, QVariant> data;
+    QHash<QString, qint64> offsets;
+    QStringList locales;
+    // Best translation so far of each key, with its index in locales.
+    QHash<QString, QPair<int, QString> > localizedData;
 };
 
 #endif
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "exectemplate.h"
+
+#include <QUrl>
+
+static QString localFile(const QString &url)
+{
+    const QUrl parsed(url);
+    return parsed.isLocalFile() ? parsed.toLocalFile() : url;
+}
+
+ExecTemplate::ExecTemplate()
+{
+}
+
+ExecTemplate ExecTemplate::parse(const QString &exec)
+{
+    ExecTemplate result;
+    const QChar *data = exec.constData();
+    const int length = exec.size();
+    int i = 0;
+
+    // The string escapes are decoded on the way, a "\\" they produce is
+    // the escape character of the quoting rules.
+    auto next = [&] () -> QChar {
+        const QChar c = data[i++];
+
+        if (c != QLatin1Char('\\') || i == length)
+            return c;
+
+        switch (data[i].unicode()) {
+        case 's': ++i; return QLatin1Char(' ');
+        case 'n': ++i; return QLatin1Char('\n');
+        case 't': ++i; return QLatin1Char('\t');
+        case 'r': ++i; return QLatin1Char('\r');
+        case '\\': ++i; return QLatin1Char('\\');
+        }
+
+        return c;
+    };
+
+    QString argument;
+    bool inArgument = false;
+    bool quoted = false;
+
+    while (i < length) {
+        QChar c = next();
+
+        if (quoted) {
+            if (c == QLatin1Char('"'))
+                quoted = false;
+            else
+                argument += (c == QLatin1Char('\\') && i < length) ? next() : c;
+            continue;
+        }
+
+        switch (c.unicode()) {
+        case ' ':
+        case '\t':
+        case '\n':
+            if (inArgument) {
+                result.append(argument);
+                argument.clear();
+                inArgument = false;
+            }
+            continue;
+        case '"':
+            quoted = true;
+            break;
+        case '\\':
+            // Not allowed by the spec outside quotes, but common.
+            argument += i < length ? next() : c;
+            break;
+        default:
+            argument += c;
+            break;
+        }
+
+        inArgument = true;
+    }
+
+    if (quoted)
+        return ExecTemplate();
+
+    if (inArgument)
+        result.append(argument);
+
+    if (result.hasFieldProgram())
+        return ExecTemplate();
+
+    return result;
+}
+
+ExecTemplate ExecTemplate::fromArguments(const QStringList &arguments)
+{
+    ExecTemplate result;
+
+    for (const QString &argument : arguments)
+        result.append(argument);
+
+    if (result.hasFieldProgram())
+        return ExecTemplate();
+
+    return result;
+}
+
+bool ExecTemplate::isEmpty() const
+{
+    return m_arguments.isEmpty();
+}
+
+QString ExecTemplate::program() const
+{
+    return m_arguments.value(0);
+}
+
+QStringList ExecTemplate::arguments() const
+{
+    return m_arguments;
+}
+
+QStringList ExecTemplate::expand(const QStringList &urls, const QString &iconName,
+                                 const QString &name, const QString &desktopFile) const
+{
+    QStringList argv;
+    argv.reserve(m_arguments.size() + urls.size());
+    int field = 0;
+
+    for (int i = 0; i < m_arguments.size(); ++i) {
+        const QString &argument = m_arguments.at(i);
+
+        if (field == m_fields.size() || m_fields.at(field) != i) {
+            argv.append(argument);
+            continue;
+        }
+
+        ++field;
+
+        // Codes that are a whole argument, they may expand to none or many.
+        if (argument.size() == 2) {
+            switch (argument.at(1).unicode()) {
+            case 'f':
+                if (!urls.isEmpty())
+                    argv.append(localFile(urls.first()));
+                continue;
+            case 'u':
+                if (!urls.isEmpty())
+                    argv.append(urls.first());
+                continue;
+            case 'F':
+                for (const QString &url : urls)
+                    argv.append(localFile(url));
+                continue;
+            case 'U':
+                argv.append(urls);
+                continue;
+            case 'i':
+                if (!iconName.isEmpty())
+                    argv << QStringLiteral("--icon") << iconName;
+                continue;
+            case 'd': case 'D': case 'n': case 'N': case 'v': case 'm':
+                continue;
+            }
+        }
+
+        QString expanded;
+        expanded.reserve(argument.size());
+
+        for (int j = 0; j < argument.size(); ++j) {
+            const QChar c = argument.at(j);
+
+            if (c != QLatin1Char('%') || j + 1 == argument.size()) {
+                expanded += c;
+                continue;
+            }
+
+            switch (argument.at(++j).unicode()) {
+            case '%':
+                expanded += c;
+                break;
+            case 'f':
+            case 'F':
+                if (!urls.isEmpty())
+                    expanded += localFile(urls.first());
+                break;
+            case 'u':
+            case 'U':
+                if (!urls.isEmpty())
+                    expanded += urls.first();
+                break;
+            case 'c':
+                expanded += name;
+                break;
+            case 'k':
+                expanded += desktopFile;
+                break;
+            }
+        }
+
+        argv.append(expanded);
+    }
+
+    return argv;
+}
+
+bool ExecTemplate::hasFieldProgram() const
+{
+    // "%U" alone expands to nothing without URLs, there is nothing to run.
+    return !m_fields.isEmpty() && m_fields.first() == 0;
+}
+
+void ExecTemplate::append(const QString &argument)
+{
+    if (argument.contains(QLatin1Char('%')))
+        m_fields.append(m_arguments.size());
+
+    m_arguments.append(argument);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXECTEMPLATE_H
+#define EXECTEMPLATE_H
+
+#include <QStringList>
+#include <QVector>
+
+/**
+ * The command line of an Exec key, split into arguments once.
+ *
+ * parse() follows the Desktop Entry spec: the string escapes of the key
+ * file (\s, \n, \t, \r, \\) first, then double quotes and the backslash
+ * escapes inside them. Field codes stay in the arguments ("%%" for a
+ * literal percent) and are replaced by expand():
+ *
+ *   %f %u       the first file or URL, removed if there is none
+ *   %F %U       every file or URL, each as its own argument
+ *   %i          "--icon" and the icon name, if there is one
+ *   %c          the name of the application
+ *   %k          the desktop file
+ *
+ * Deprecated (%d %D %n %N %v %m) and unknown codes are removed.
+ */
+class ExecTemplate
+{
+public:
+    ExecTemplate();
+
+    // Empty if the quoting is broken or the program is a field code.
+    static ExecTemplate parse(const QString &exec);
+    static ExecTemplate fromArguments(const QStringList &arguments);
+
+    bool isEmpty() const;
+    QString program() const;
+
+    // Unexpanded, as saved by fromArguments().
+    QStringList arguments() const;
+
+    QStringList expand(const QStringList &urls, const QString &iconName,
+                       const QString &name, const QString &desktopFile) const;
+
+    bool operator==(const ExecTemplate &other) const { return m_arguments == other.m_arguments; }
+    bool operator!=(const ExecTemplate &other) const { return m_arguments != other.m_arguments; }
+
+private:
+    void append(const QString &argument);
+    bool hasFieldProgram() const;
+
+private:
+    QStringList m_arguments;
+    // Arguments with field codes, the others are copied as they are.
+    QVector<int> m_fields;
+};
+
+#endif // EXECTEMPLATE_H
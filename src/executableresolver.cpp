@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "executableresolver.h"
+#include "trace.h"
+
+#include <QFileInfo>
+#include <QDir>
+
+ExecutableResolver *ExecutableResolver::self()
+{
+    static ExecutableResolver *s_self = new ExecutableResolver;
+    return s_self;
+}
+
+ExecutableResolver::ExecutableResolver(QObject *parent)
+    : QObject(parent)
+{
+    const QString path = QString::fromLocal8Bit(qgetenv("PATH"));
+
+    for (const QString &directory : path.split(QLatin1Char(':'))) {
+        if (directory.isEmpty())
+            continue;
+
+        const QString cleaned = QDir::cleanPath(QDir(directory).absolutePath());
+
+        if (!m_paths.contains(cleaned))
+            m_paths.append(cleaned);
+    }
+
+    m_changedTimer.setInterval(500);
+    m_changedTimer.setSingleShot(true);
+    connect(&m_changedTimer, &QTimer::timeout, this, &ExecutableResolver::changed);
+
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &ExecutableResolver::onDirectoryChanged);
+}
+
+QString ExecutableResolver::find(const QString &program)
+{
+    if (program.isEmpty())
+        return QString();
+
+    if (program.contains(QLatin1Char('/'))) {
+        const QFileInfo info(QDir::cleanPath(QDir::current().absoluteFilePath(program)));
+        return listing(info.path()).contains(info.fileName()) ? info.filePath() : QString();
+    }
+
+    for (const QString &directory : qAsConst(m_paths)) {
+        if (listing(directory).contains(program))
+            return directory + QLatin1Char('/') + program;
+    }
+
+    return QString();
+}
+
+bool ExecutableResolver::exists(const QString &program)
+{
+    return !find(program).isEmpty();
+}
+
+const QSet<QString> &ExecutableResolver::listing(const QString &directory)
+{
+    auto it = m_listings.find(directory);
+    if (it != m_listings.end())
+        return it.value();
+
+    TRACE_SPAN("ExecutableResolver::listing");
+
+    // Watched first, so nothing installed while listing is missed. A
+    // directory that does not exist can't be watched, its nearest existing
+    // parent is, to notice it being created (again).
+    if (QFileInfo(directory).isDir()) {
+        watch(directory);
+    } else {
+        QString parent = directory;
+        do {
+            parent = QFileInfo(parent).path();
+        } while (!QFileInfo(parent).isDir() && parent != QLatin1String("/"));
+
+        watch(parent);
+        m_missingDirectories.insert(parent, directory);
+    }
+
+    const QStringList entries = QDir(directory).entryList(QDir::Files | QDir::Executable | QDir::System);
+
+    QSet<QString> executables;
+    executables.reserve(entries.size());
+    for (const QString &entry : entries)
+        executables.insert(entry);
+
+    return m_listings.insert(directory, executables).value();
+}
+
+void ExecutableResolver::watch(const QString &directory)
+{
+    if (!m_watcher.directories().contains(directory))
+        m_watcher.addPath(directory);
+}
+
+void ExecutableResolver::onDirectoryChanged(const QString &directory)
+{
+    m_listings.remove(directory);
+
+    // Listed again on the next lookup, and looked for again if they are
+    // still missing.
+    for (const QString &missing : m_missingDirectories.values(directory))
+        m_listings.remove(missing);
+    m_missingDirectories.remove(directory);
+
+    m_changedTimer.start();
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXECUTABLERESOLVER_H
+#define EXECUTABLERESOLVER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QStringList>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+
+/**
+ * Finds executables like QStandardPaths::findExecutable(), from a cached
+ * listing of each directory instead of a stat() per lookup.
+ *
+ * Every $PATH entry, and the directory of every absolute program asked
+ * for, is listed once and watched (inotify), or its nearest existing
+ * parent if it does not exist. A change drops the listing of that
+ * directory, and of missing ones below it, and, after a short delay to let package managers
+ * finish, emits changed(). Used from the GUI thread only.
+ */
+class ExecutableResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ExecutableResolver *self();
+
+    // Absolute path of program, or an empty string.
+    QString find(const QString &program);
+    bool exists(const QString &program);
+
+signals:
+    void changed();
+
+private:
+    explicit ExecutableResolver(QObject *parent = nullptr);
+
+    const QSet<QString> &listing(const QString &directory);
+    void watch(const QString &directory);
+    void onDirectoryChanged(const QString &directory);
+
+private:
+    QStringList m_paths;
+    QHash<QString, QSet<QString>> m_listings;
+    // Watched parents of listed directories that do not exist.
+    QMultiHash<QString, QString> m_missingDirectories;
+    QFileSystemWatcher m_watcher;
+    QTimer m_changedTimer;
+};
+
+#endif // EXECUTABLERESOLVER_H
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "iconcache.h"
+#include "iconthemeindex.h"
+#include "metrics.h"
+
+#include <QSettings>
+
+#include <climits>
+
+static const qint64 MiB = 1024 * 1024;
+
+static qint64 pixmapCost(const QPixmap &pixmap)
+{
+    return qint64(pixmap.width()) * pixmap.height() * qMax(pixmap.depth(), 8) / 8;
+}
+
+IconCache *IconCache::self()
+{
+    static IconCache *s_self = new IconCache;
+    return s_self;
+}
+
+IconCache::IconCache(QObject *parent)
+    : QObject(parent)
+    , m_textureBytes(0)
+    , m_hits(0)
+    , m_misses(0)
+{
+    QSettings settings("cutefishos", "launcher");
+    m_budget = settings.value("IconCacheBudget", 64).toLongLong() * MiB;
+    m_lowWatermark = settings.value("IconCacheLowWatermark", 16).toLongLong() * MiB;
+    m_trimDelay = settings.value("IconCacheTrimDelay", 30).toInt();
+
+    updateMaxCost();
+
+    connect(IconThemeIndex::self(), &IconThemeIndex::themeChanged, this, &IconCache::clear);
+    connect(IconThemeIndex::self(), &IconThemeIndex::iconsChanged, this, &IconCache::invalidate);
+}
+
+QString IconCache::key(const QString &source, int size, qreal devicePixelRatio)
+{
+    return QStringLiteral("%1|%2|%3").arg(source).arg(size).arg(devicePixelRatio);
+}
+
+QPixmap IconCache::find(const QString &key)
+{
+    QPixmap *pixmap = m_pixmaps.object(key);
+
+    if (!pixmap) {
+        ++m_misses;
+        Metrics::increment(Metrics::IconCacheMisses);
+        return QPixmap();
+    }
+
+    ++m_hits;
+    Metrics::increment(Metrics::IconCacheHits);
+    return *pixmap;
+}
+
+void IconCache::insert(const QString &key, const QPixmap &pixmap)
+{
+    if (pixmap.isNull())
+        return;
+
+    updateMaxCost();
+    m_pixmaps.insert(key, new QPixmap(pixmap), int(qMin<qint64>(pixmapCost(pixmap), INT_MAX)));
+
+    emit statisticsChanged();
+}
+
+void IconCache::addTextureBytes(qint64 bytes)
+{
+    m_textureBytes.fetchAndAddRelaxed(bytes);
+}
+
+void IconCache::releaseTextureBytes(qint64 bytes)
+{
+    m_textureBytes.fetchAndAddRelaxed(-bytes);
+}
+
+qint64 IconCache::budget() const
+{
+    return m_budget;
+}
+
+void IconCache::setBudget(qint64 budget)
+{
+    if (m_budget == budget)
+        return;
+
+    m_budget = budget;
+    updateMaxCost();
+
+    emit budgetChanged();
+    emit statisticsChanged();
+}
+
+qint64 IconCache::lowWatermark() const
+{
+    return m_lowWatermark;
+}
+
+int IconCache::trimDelay() const
+{
+    return m_trimDelay;
+}
+
+qint64 IconCache::bytesHeld() const
+{
+    return pixmapBytes() + textureBytes();
+}
+
+qint64 IconCache::pixmapBytes() const
+{
+    return m_pixmaps.totalCost();
+}
+
+qint64 IconCache::textureBytes() const
+{
+    return m_textureBytes.loadAcquire();
+}
+
+quint64 IconCache::hits() const
+{
+    return m_hits;
+}
+
+quint64 IconCache::misses() const
+{
+    return m_misses;
+}
+
+qreal IconCache::hitRatio() const
+{
+    const quint64 total = m_hits + m_misses;
+    return total ? qreal(m_hits) / total : 0.0;
+}
+
+void IconCache::trim(qint64 bytes)
+{
+    // QCache drops the least recently used entries first.
+    m_pixmaps.setMaxCost(int(qBound<qint64>(0, bytes - textureBytes(), INT_MAX)));
+    updateMaxCost();
+
+    emit statisticsChanged();
+}
+
+void IconCache::trimToLowWatermark()
+{
+    trim(m_lowWatermark);
+}
+
+void IconCache::clear()
+{
+    m_pixmaps.clear();
+
+    emit statisticsChanged();
+}
+
+void IconCache::invalidate(const QStringList &names)
+{
+    for (const QString &key : m_pixmaps.keys()) {
+        // Keys start with the source name, which resolves through the
+        // "a-b-c", "a-b", "a" fallback chain.
+        QString name = key.left(key.indexOf('|'));
+
+        while (!name.isEmpty()) {
+            if (names.contains(name)) {
+                m_pixmaps.remove(key);
+                break;
+            }
+
+            name.truncate(qMax(name.lastIndexOf('-'), 0));
+        }
+    }
+
+    emit statisticsChanged();
+}
+
+void IconCache::updateMaxCost()
+{
+    // Textures can't be evicted from here, so they shrink what is left
+    // of the budget for pixmaps.
+    m_pixmaps.setMaxCost(int(qBound<qint64>(0, m_budget - textureBytes(), INT_MAX)));
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QObject>
+#include <QAtomicInteger>
+#include <QCache>
+#include <QPixmap>
+
+/**
+ * Owns every rasterized icon of the launcher.
+ *
+ * Pixmaps are kept in an LRU with a byte budget that also accounts for
+ * the textures IconItem uploads, items only hold an image until it is
+ * uploaded. Settings live in the "cutefishos/launcher" config file:
+ * IconCacheBudget and IconCacheLowWatermark (MiB), IconCacheTrimDelay (s).
+ */
+class IconCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qint64 budget READ budget WRITE setBudget NOTIFY budgetChanged)
+    Q_PROPERTY(qint64 bytesHeld READ bytesHeld NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 pixmapBytes READ pixmapBytes NOTIFY statisticsChanged)
+    Q_PROPERTY(qint64 textureBytes READ textureBytes NOTIFY statisticsChanged)
+    Q_PROPERTY(quint64 hits READ hits NOTIFY statisticsChanged)
+    Q_PROPERTY(quint64 misses READ misses NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal hitRatio READ hitRatio NOTIFY statisticsChanged)
+
+public:
+    static IconCache *self();
+
+    static QString key(const QString &source, int size, qreal devicePixelRatio);
+
+    QPixmap find(const QString &key);
+    void insert(const QString &key, const QPixmap &pixmap);
+
+    // Called from the render thread when textures are created or deleted.
+    void addTextureBytes(qint64 bytes);
+    void releaseTextureBytes(qint64 bytes);
+
+    qint64 budget() const;
+    void setBudget(qint64 budget);
+
+    qint64 lowWatermark() const;
+    int trimDelay() const;
+
+    qint64 bytesHeld() const;
+    qint64 pixmapBytes() const;
+    qint64 textureBytes() const;
+
+    quint64 hits() const;
+    quint64 misses() const;
+    qreal hitRatio() const;
+
+    Q_INVOKABLE void trim(qint64 bytes);
+    Q_INVOKABLE void trimToLowWatermark();
+    Q_INVOKABLE void clear();
+
+signals:
+    void budgetChanged();
+    void statisticsChanged();
+
+private:
+    explicit IconCache(QObject *parent = nullptr);
+
+    void invalidate(const QStringList &names);
+    void updateMaxCost();
+
+private:
+    QCache<QString, QPixmap> m_pixmaps;
+    QAtomicInteger<qint64> m_textureBytes;
+
+    qint64 m_budget;
+    qint64 m_lowWatermark;
+    int m_trimDelay;
+
+    quint64 m_hits;
+    quint64 m_misses;
+};
+
+#endif // ICONCACHE_H
@@ -1,15 +1,56 @@
 #include "iconitem.h"
+#include "iconthemeindex.h"
+#include "iconcache.h"
+#include "trace.h"
+#include "metrics.h"
 #include <QSGSimpleTextureNode>
 #include <QSGTexture>
 #include <QQuickWindow>
 #include <QApplication>
 #include <QIcon>
+#include <QtMath>
+
+// Reports the size of its texture to the icon cache budget.
+class IconTextureNode : public QSGSimpleTextureNode
+{
+public:
+    IconTextureNode()
+        : m_bytes(0)
+    {
+        setOwnsTexture(true);
+    }
+
+    ~IconTextureNode()
+    {
+        IconCache::self()->releaseTextureBytes(m_bytes);
+    }
+
+    void setIconTexture(QSGTexture *texture)
+    {
+        const QSize size = texture ? texture->textureSize() : QSize();
+
+        IconCache::self()->releaseTextureBytes(m_bytes);
+        m_bytes = qint64(size.width()) * size.height() * 4;
+        IconCache::self()->addTextureBytes(m_bytes);
+
+        // Owning the texture, the node deletes the previous one.
+        setTexture(texture);
+    }
+
+private:
+    qint64 m_bytes;
+};
 
 IconItem::IconItem(QQuickItem *parent)
     : QQuickItem(parent)
+    , m_textureChanged(false)
 {
     setFlag(ItemHasContents, true);
     setSmooth(true);
+
+    // Re-resolve in place when the theme or one of our icons changes.
+    connect(IconThemeIndex::self(), &IconThemeIndex::themeChanged, this, &IconItem::refresh);
+    connect(IconThemeIndex::self(), &IconThemeIndex::iconsChanged, this, &IconItem::onIconsChanged);
 }
 
 void IconItem::setSource(const QVariant &source)
@@ -48,17 +89,31 @@ QSGNode *IconItem::updatePaintNode(QSGNode *oldNode, QQuickItem::UpdatePaintNode
 {
     Q_UNUSED(updatePaintNodeData);
 
-    if (m_iconPixmap.isNull() || width() == 0.0 || height() == 0.0) {
+    if ((m_textureChanged && m_iconImage.isNull()) || width() == 0.0 || height() == 0.0) {
         delete oldNode;
         return nullptr;
     }
 
-    QSGSimpleTextureNode *textureNode = dynamic_cast<QSGSimpleTextureNode *>(oldNode);
+    IconTextureNode *textureNode = dynamic_cast<IconTextureNode *>(oldNode);
 
-    if (!textureNode) {
+    if (!textureNode && !m_textureChanged) {
+        // The scene graph dropped our node after we released the image,
+        // get it back from the cache on the GUI thread.
         delete oldNode;
-        textureNode = new QSGSimpleTextureNode;
-        textureNode->setTexture(window()->createTextureFromImage(m_iconPixmap.toImage(), QQuickWindow::TextureCanUseAtlas));
+        QMetaObject::invokeMethod(this, "refresh", Qt::QueuedConnection);
+        return nullptr;
+    }
+
+    if (m_textureChanged) {
+        if (!textureNode) {
+            delete oldNode;
+            textureNode = new IconTextureNode;
+        }
+
+        textureNode->setIconTexture(window()->createTextureFromImage(m_iconImage, QQuickWindow::TextureCanUseAtlas));
+        Metrics::increment(Metrics::TextureUploads);
+        m_iconImage = QImage();
+        m_textureChanged = false;
     }
 
     textureNode->setFiltering(smooth() ? QSGTexture::Linear : QSGTexture::Nearest);
@@ -98,8 +153,30 @@ void IconItem::refresh()
     polish();
 }
 
+void IconItem::onIconsChanged(const QStringList &names)
+{
+    if (m_source.type() != QVariant::String)
+        return;
+
+    // The index falls back from "a-b-c" to "a-b" and "a", so a change to
+    // any of those can change what we show.
+    QString name = m_source.toString();
+
+    while (!name.isEmpty()) {
+        if (names.contains(name)) {
+            refresh();
+            return;
+        }
+
+        int dash = name.lastIndexOf('-');
+        name.truncate(qMax(dash, 0));
+    }
+}
+
 void IconItem::loadPixmap()
 {
+    TRACE_SPAN("IconItem::loadPixmap");
+
     if (!isComponentComplete())
         return;
 
@@ -107,25 +184,31 @@ void IconItem::loadPixmap()
 
     if (size <= 0) {
         // Clear pixmap
-        delete &m_iconPixmap;
-        m_iconPixmap = QPixmap();
+        m_iconImage = QImage();
+        m_textureChanged = true;
         update();
         return;
     }
 
     QString sourceString = m_source.toString();
 
+    // Named icons and files are shared by every item showing them.
+    const bool cacheable = m_source.type() == QVariant::String;
+    const QString cacheKey = cacheable ? IconCache::key(sourceString, size, qApp->devicePixelRatio()) : QString();
+    QPixmap pixmap = cacheable ? IconCache::self()->find(cacheKey) : QPixmap();
+    const bool cached = !pixmap.isNull();
+
     if (m_source.canConvert<QIcon>()) {
         QIcon icon = m_source.value<QIcon>();
-        m_iconPixmap = icon.pixmap(QSize(size * qApp->devicePixelRatio(),
-                                         size * qApp->devicePixelRatio()));
-        m_iconPixmap.setDevicePixelRatio(qApp->devicePixelRatio());
+        pixmap = icon.pixmap(QSize(size * qApp->devicePixelRatio(),
+                                   size * qApp->devicePixelRatio()));
+        pixmap.setDevicePixelRatio(qApp->devicePixelRatio());
     } else if (m_source.canConvert<QImage>()) {
         QImage image = m_source.value<QImage>();
-        m_iconPixmap = QPixmap::fromImage(image).scaled(QSize(size * qApp->devicePixelRatio(),
-                                                              size * qApp->devicePixelRatio()));
-        m_iconPixmap.setDevicePixelRatio(qApp->devicePixelRatio());
-    } else if (!m_source.isNull()) {
+        pixmap = QPixmap::fromImage(image).scaled(QSize(size * qApp->devicePixelRatio(),
+                                                        size * qApp->devicePixelRatio()));
+        pixmap.setDevicePixelRatio(qApp->devicePixelRatio());
+    } else if (!m_source.isNull() && pixmap.isNull()) {
         QString localFile;
 
         if (sourceString.startsWith("file:"))
@@ -138,21 +221,40 @@ void IconItem::loadPixmap()
             localFile = sourceString;
 
         if (!localFile.isEmpty()) {
-            m_iconPixmap.load(localFile);
-            if (!m_iconPixmap.isNull()) {
-                m_iconPixmap = m_iconPixmap.scaled(QSize(size * qApp->devicePixelRatio(),
-                                                         size * qApp->devicePixelRatio()));
-                m_iconPixmap.setDevicePixelRatio(qApp->devicePixelRatio());
+            pixmap.load(localFile);
+            if (!pixmap.isNull()) {
+                pixmap = pixmap.scaled(QSize(size * qApp->devicePixelRatio(),
+                                             size * qApp->devicePixelRatio()));
+                pixmap.setDevicePixelRatio(qApp->devicePixelRatio());
             }
         }
     }
 
-    if (m_iconPixmap.isNull()) {
+    if (pixmap.isNull() && !sourceString.isEmpty()) {
+        // Resolve through the prebuilt index first, QIcon::fromTheme()
+        // probes every directory of the theme chain on each lookup.
+        const QString fileName = IconThemeIndex::self()->lookup(sourceString, size, qCeil(qApp->devicePixelRatio()));
+
+        if (!fileName.isEmpty()) {
+            QIcon icon(fileName);
+            pixmap = icon.pixmap(QSize(size * qApp->devicePixelRatio(),
+                                       size * qApp->devicePixelRatio()));
+            pixmap.setDevicePixelRatio(qApp->devicePixelRatio());
+        }
+    }
+
+    if (pixmap.isNull()) {
         QIcon icon = QIcon::fromTheme(sourceString, QIcon::fromTheme("application-x-desktop"));
-        m_iconPixmap = icon.pixmap(QSize(size * qApp->devicePixelRatio(),
-                                         size * qApp->devicePixelRatio()));
-        m_iconPixmap.setDevicePixelRatio(qApp->devicePixelRatio());
+        pixmap = icon.pixmap(QSize(size * qApp->devicePixelRatio(),
+                                   size * qApp->devicePixelRatio()));
+        pixmap.setDevicePixelRatio(qApp->devicePixelRatio());
     }
 
+    if (cacheable && !cached)
+        IconCache::self()->insert(cacheKey, pixmap);
+
+    // Shares the data with the cached pixmap and is dropped once uploaded.
+    m_iconImage = pixmap.toImage();
+    m_textureChanged = true;
     update();
 }
@@ -2,7 +2,7 @@
 #define ICONITEM_H
 
 #include <QQuickItem>
-#include <QPixmap>
+#include <QImage>
 #include <QPointer>
 
 class IconItem : public QQuickItem
@@ -31,6 +31,7 @@ public:
 
 private:
     void loadPixmap();
+    void onIconsChanged(const QStringList &names);
 
 signals:
     void sourceChanged();
@@ -38,7 +39,8 @@ signals:
 
 private:
     QVariant m_source;
-    QPixmap m_iconPixmap;
+    QImage m_iconImage;
+    bool m_textureChanged;
 };
 
 #endif // ICONITEM_H
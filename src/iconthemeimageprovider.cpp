@@ -18,6 +18,7 @@
  */
 
 #include "iconthemeimageprovider.h"
+#include "iconthemeindex.h"
 #include <QIcon>
 
 IconThemeImageProvider::IconThemeImageProvider()
@@ -44,6 +45,10 @@ QPixmap IconThemeImageProvider::requestPixmap(const QString &id, QSize *realSize
         return QPixmap(id).scaled(size);
 
     // Return icon from theme or fallback to a generic icon
+    const QString fileName = IconThemeIndex::self()->lookup(id, qMax(size.width(), size.height()));
+    if (!fileName.isEmpty())
+        return QIcon(fileName).pixmap(size);
+
     QIcon icon = QIcon::fromTheme(id);
     if (icon.isNull())
         icon = QIcon::fromTheme(QLatin1String("application-x-desktop"));
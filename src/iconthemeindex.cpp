@@ -0,0 +1,545 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "iconthemeindex.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QStandardPaths>
+#include <QDirIterator>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QSet>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QFile>
+#include <QIcon>
+#include <QDir>
+
+#include <climits>
+
+// Bump whenever the layout of the cache file changes.
+static const quint32 CacheVersion = 1;
+
+static const char *const Extensions[] = { ".png", ".svg", ".xpm" };
+static const int ExtensionCount = 3;
+
+typedef QHash<QString, QHash<QString, QString>> IniGroups;
+
+static QDataStream &operator<<(QDataStream &out, const IconThemeIndex::Directory &dir)
+{
+    out << dir.path << dir.modified << dir.depth << dir.size << dir.scale
+        << dir.minSize << dir.maxSize << dir.threshold << dir.type;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, IconThemeIndex::Directory &dir)
+{
+    in >> dir.path >> dir.modified >> dir.depth >> dir.size >> dir.scale
+       >> dir.minSize >> dir.maxSize >> dir.threshold >> dir.type;
+    return in;
+}
+
+static QDataStream &operator<<(QDataStream &out, const IconThemeIndex::Location &location)
+{
+    out << location.directory << location.extension;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, IconThemeIndex::Location &location)
+{
+    in >> location.directory >> location.extension;
+    return in;
+}
+
+static qint64 modifiedTime(const QString &path)
+{
+    QFileInfo info(path);
+    return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+static QString cacheFileName(const QString &themeName)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + QStringLiteral("/icon-theme-%1.index").arg(themeName);
+}
+
+// index.theme holds one group per directory, so it is read in one go
+// instead of going through DesktopProperties once per group.
+static IniGroups parseIndexTheme(const QString &fileName)
+{
+    IniGroups groups;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return groups;
+
+    QHash<QString, QString> *current = nullptr;
+
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        if (line.startsWith('[') && line.endsWith(']')) {
+            current = &groups[line.mid(1, line.length() - 2)];
+            continue;
+        }
+
+        int equal = line.indexOf('=');
+        if (current && equal > 0)
+            current->insert(line.left(equal).trimmed(), line.mid(equal + 1).trimmed());
+    }
+
+    return groups;
+}
+
+static QStringList splitList(const QString &value)
+{
+    QStringList list;
+
+    for (const QString &item : value.split(',')) {
+        const QString trimmed = item.trimmed();
+        if (!trimmed.isEmpty())
+            list.append(trimmed);
+    }
+
+    return list;
+}
+
+static IconThemeIndex::Directory parseDirectory(const QHash<QString, QString> &group)
+{
+    IconThemeIndex::Directory dir;
+    dir.size = group.value("Size").toInt();
+    dir.scale = qMax(1, group.value("Scale", "1").toInt());
+    dir.minSize = group.value("MinSize", QString::number(dir.size)).toInt();
+    dir.maxSize = group.value("MaxSize", QString::number(dir.size)).toInt();
+    dir.threshold = group.value("Threshold", "2").toInt();
+
+    const QString type = group.value("Type", "Threshold");
+    if (type == QLatin1String("Fixed"))
+        dir.type = IconThemeIndex::Fixed;
+    else if (type == QLatin1String("Scalable"))
+        dir.type = IconThemeIndex::Scalable;
+    else
+        dir.type = IconThemeIndex::Threshold;
+
+    return dir;
+}
+
+static void listDirectory(IconThemeIndex::Data *data, int index, QSet<QString> *names)
+{
+    QDirIterator it(data->directories.at(index).path, QDir::Files);
+
+    while (it.hasNext()) {
+        it.next();
+        const QString fileName = it.fileName();
+
+        for (int ext = 0; ext < ExtensionCount; ++ext) {
+            if (!fileName.endsWith(QLatin1String(Extensions[ext])))
+                continue;
+
+            IconThemeIndex::Location location;
+            location.directory = index;
+            location.extension = ext;
+
+            // Keep every list ordered by directory, which is also the
+            // order of the inheritance chain.
+            const QString name = fileName.left(fileName.length() - 4);
+            QVector<IconThemeIndex::Location> &locations = data->icons[name];
+            int pos = locations.size();
+            while (pos > 0 && locations.at(pos - 1).directory > index)
+                --pos;
+            locations.insert(pos, location);
+
+            if (names)
+                names->insert(name);
+            break;
+        }
+    }
+}
+
+static bool matchesSize(const IconThemeIndex::Directory &dir, int size, int scale)
+{
+    if (dir.scale != scale)
+        return false;
+
+    switch (dir.type) {
+    case IconThemeIndex::Fixed:
+        return dir.size == size;
+    case IconThemeIndex::Scalable:
+        return dir.minSize <= size && size <= dir.maxSize;
+    case IconThemeIndex::Threshold:
+        return dir.size - dir.threshold <= size && size <= dir.size + dir.threshold;
+    }
+
+    return false;
+}
+
+static int sizeDistance(const IconThemeIndex::Directory &dir, int size, int scale)
+{
+    const int scaled = size * scale;
+
+    switch (dir.type) {
+    case IconThemeIndex::Fixed:
+        return qAbs(dir.size * dir.scale - scaled);
+    case IconThemeIndex::Scalable:
+        if (scaled < dir.minSize * dir.scale)
+            return dir.minSize * dir.scale - scaled;
+        if (scaled > dir.maxSize * dir.scale)
+            return scaled - dir.maxSize * dir.scale;
+        return 0;
+    case IconThemeIndex::Threshold:
+        if (scaled < (dir.size - dir.threshold) * dir.scale)
+            return (dir.size - dir.threshold) * dir.scale - scaled;
+        if (scaled > (dir.size + dir.threshold) * dir.scale)
+            return scaled - (dir.size + dir.threshold) * dir.scale;
+        return 0;
+    }
+
+    return INT_MAX;
+}
+
+IconThemeIndex *IconThemeIndex::self()
+{
+    static IconThemeIndex *s_self = new IconThemeIndex;
+    return s_self;
+}
+
+IconThemeIndex::IconThemeIndex(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+{
+    // Builds are serialized so each one starts from the previous result.
+    m_pool.setMaxThreadCount(1);
+
+    // Package managers touch many directories in a row.
+    m_rebuildTimer.setInterval(500);
+    m_rebuildTimer.setSingleShot(true);
+    connect(&m_rebuildTimer, &QTimer::timeout, this, &IconThemeIndex::rebuild);
+
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, &m_rebuildTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, &m_rebuildTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(this, &IconThemeIndex::ready, this, &IconThemeIndex::updateWatches, Qt::QueuedConnection);
+
+    rebuild();
+}
+
+bool IconThemeIndex::isReady() const
+{
+    return !data().isNull();
+}
+
+QString IconThemeIndex::themeName() const
+{
+    QSharedPointer<const Data> d = data();
+    return d ? d->themeName : QString();
+}
+
+QString IconThemeIndex::lookup(const QString &name, int size, int scale) const
+{
+    QSharedPointer<const Data> d = data();
+
+    if (!d || name.isEmpty())
+        return QString();
+
+    // Same fallback as the icon theme spec: "a-b-c", "a-b", "a".
+    QString iconName = name;
+    QHash<QString, QVector<Location>>::const_iterator it = d->icons.constFind(iconName);
+
+    while (it == d->icons.constEnd()) {
+        int dash = iconName.lastIndexOf('-');
+        if (dash <= 0)
+            return QString();
+
+        iconName.truncate(dash);
+        it = d->icons.constFind(iconName);
+    }
+
+    const QVector<Location> &locations = it.value();
+    const int depth = d->directories.at(locations.first().directory).depth;
+
+    const Location *best = nullptr;
+    int bestDistance = INT_MAX;
+
+    for (const Location &location : locations) {
+        const Directory &dir = d->directories.at(location.directory);
+
+        // Only the closest theme of the chain that has the icon counts.
+        if (dir.depth != depth)
+            break;
+
+        if (dir.type == Fallback) {
+            if (!best)
+                best = &location;
+            continue;
+        }
+
+        if (matchesSize(dir, size, scale)) {
+            best = &location;
+            break;
+        }
+
+        int distance = sizeDistance(dir, size, scale);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = &location;
+        }
+    }
+
+    if (!best)
+        return QString();
+
+    return d->directories.at(best->directory).path + '/' + iconName
+            + QLatin1String(Extensions[best->extension]);
+}
+
+void IconThemeIndex::checkTheme()
+{
+    if (QIcon::themeName() != m_buildThemeName)
+        rebuild();
+}
+
+void IconThemeIndex::rebuild()
+{
+    m_buildThemeName = QIcon::themeName();
+
+    // QIcon's theme settings are only read on the GUI thread.
+    QStringList searchPaths = QIcon::themeSearchPaths();
+    searchPaths.removeAll(QStringLiteral(":/icons"));
+
+    QStringList fallbackPaths = QIcon::fallbackSearchPaths();
+    fallbackPaths.append(QStringLiteral("/usr/share/pixmaps"));
+
+    QtConcurrent::run(&m_pool, IconThemeIndex::build, this, m_buildThemeName, searchPaths, fallbackPaths);
+}
+
+void IconThemeIndex::build(IconThemeIndex *index, const QString &themeName,
+                           const QStringList &searchPaths, const QStringList &fallbackPaths)
+{
+    // An index already in memory for the same theme is the baseline,
+    // otherwise whatever was persisted by the last run.
+    QSharedPointer<const Data> previous = index->data();
+    QSharedPointer<const Data> baseline = previous;
+
+    if (!baseline || baseline->themeName != themeName) {
+        QSharedPointer<Data> cached(new Data);
+
+        QFile file(cacheFileName(themeName));
+        if (file.open(QIODevice::ReadOnly)) {
+            QDataStream in(&file);
+            quint32 version = 0;
+            in >> version;
+
+            if (version == CacheVersion) {
+                in >> cached->themeName >> cached->themeFiles >> cached->themeFilesModified
+                   >> cached->directories >> cached->icons;
+            }
+
+            if (in.status() != QDataStream::Ok || cached->themeName != themeName)
+                cached.reset(new Data);
+        }
+
+        baseline = cached;
+    }
+
+    // Walk the inheritance chain, hicolor always comes last.
+    QSharedPointer<Data> data(new Data);
+    data->themeName = themeName;
+
+    QStringList chain { themeName };
+    QList<IniGroups> themes;
+
+    for (int i = 0; i < chain.size(); ++i) {
+        IniGroups groups;
+
+        for (const QString &base : searchPaths) {
+            const QString fileName = base + '/' + chain.at(i) + QStringLiteral("/index.theme");
+            if (!QFile::exists(fileName))
+                continue;
+
+            groups = parseIndexTheme(fileName);
+            data->themeFiles.append(fileName);
+            data->themeFilesModified.append(modifiedTime(fileName));
+            break;
+        }
+
+        themes.append(groups);
+
+        for (const QString &parent : splitList(groups.value("Icon Theme").value("Inherits"))) {
+            if (!chain.contains(parent))
+                chain.append(parent);
+        }
+
+        if (i == chain.size() - 1 && !chain.contains(QStringLiteral("hicolor")))
+            chain.append(QStringLiteral("hicolor"));
+    }
+
+    for (int depth = 0; depth < chain.size(); ++depth) {
+        const IniGroups &groups = themes.at(depth);
+        const QHash<QString, QString> &theme = groups.value("Icon Theme");
+        const QStringList subdirs = splitList(theme.value("Directories"))
+                + splitList(theme.value("ScaledDirectories"));
+
+        for (const QString &base : searchPaths) {
+            const QString themeDir = base + '/' + chain.at(depth);
+            if (!QFileInfo::exists(themeDir))
+                continue;
+
+            data->roots.append(themeDir);
+
+            for (const QString &subdir : subdirs) {
+                Directory dir = parseDirectory(groups.value(subdir));
+                dir.path = themeDir + '/' + subdir;
+                dir.depth = depth;
+                dir.modified = modifiedTime(dir.path);
+
+                if (dir.modified >= 0)
+                    data->directories.append(dir);
+            }
+        }
+    }
+
+    for (const QString &path : fallbackPaths) {
+        Directory dir;
+        dir.path = path;
+        dir.depth = chain.size();
+        dir.type = Fallback;
+        dir.modified = modifiedTime(path);
+
+        if (dir.modified >= 0)
+            data->directories.append(dir);
+    }
+
+    // Reuse the previous listing when the theme layout did not change and
+    // only list the directories that were modified since.
+    bool relisted = true;
+    bool dirty = true;
+    QSet<QString> affected;
+
+    if (baseline->themeFiles == data->themeFiles
+            && baseline->themeFilesModified == data->themeFilesModified
+            && baseline->directories.size() == data->directories.size()) {
+        relisted = false;
+
+        QVector<int> changed;
+        for (int i = 0; i < data->directories.size(); ++i) {
+            if (baseline->directories.at(i).path != data->directories.at(i).path) {
+                relisted = true;
+                break;
+            }
+
+            if (baseline->directories.at(i).modified != data->directories.at(i).modified)
+                changed.append(i);
+        }
+
+        if (!relisted) {
+            data->icons = baseline->icons;
+            dirty = !changed.isEmpty();
+
+            for (auto it = data->icons.begin(); dirty && it != data->icons.end();) {
+                QVector<Location> &locations = it.value();
+                for (int i = locations.size() - 1; i >= 0; --i) {
+                    if (changed.contains(locations.at(i).directory)) {
+                        locations.remove(i);
+                        affected.insert(it.key());
+                    }
+                }
+
+                if (locations.isEmpty())
+                    it = data->icons.erase(it);
+                else
+                    ++it;
+            }
+
+            for (int i : changed)
+                listDirectory(data.data(), i, &affected);
+        }
+    }
+
+    if (relisted) {
+        for (int i = 0; i < data->directories.size(); ++i)
+            listDirectory(data.data(), i, nullptr);
+    }
+
+    index->setData(data);
+
+    // Names are only worth reporting when the same theme was already in
+    // use, everything else invalidates all icons anyway.
+    if (!previous || previous->themeName != themeName || relisted)
+        emit index->themeChanged();
+    else if (!affected.isEmpty())
+        emit index->iconsChanged(affected.values());
+
+    if (dirty) {
+        QDir().mkpath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+
+        QSaveFile file(cacheFileName(themeName));
+        if (file.open(QIODevice::WriteOnly)) {
+            QDataStream out(&file);
+            out << CacheVersion;
+            out << data->themeName << data->themeFiles << data->themeFilesModified
+                << data->directories << data->icons;
+            file.commit();
+        }
+    }
+}
+
+void IconThemeIndex::updateWatches()
+{
+    QSharedPointer<const Data> d = data();
+    if (!d)
+        return;
+
+    QStringList paths = d->roots + d->themeFiles;
+    for (const Directory &dir : d->directories)
+        paths.append(dir.path);
+
+    const QStringList watched = m_watcher->files() + m_watcher->directories();
+    QStringList removed;
+    for (const QString &path : watched) {
+        if (!paths.contains(path))
+            removed.append(path);
+    }
+
+    QStringList added;
+    for (const QString &path : paths) {
+        if (!watched.contains(path))
+            added.append(path);
+    }
+
+    if (!removed.isEmpty())
+        m_watcher->removePaths(removed);
+    if (!added.isEmpty())
+        m_watcher->addPaths(added);
+}
+
+void IconThemeIndex::setData(QSharedPointer<const Data> data)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_data = data;
+    }
+
+    emit ready();
+}
+
+QSharedPointer<const IconThemeIndex::Data> IconThemeIndex::data() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_data;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ICONTHEMEINDEX_H
+#define ICONTHEMEINDEX_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * Launcher-side index of the current icon theme.
+ *
+ * index.theme and the whole inheritance chain are parsed once, every icon
+ * directory is listed once, and the result is kept as a hash from icon name
+ * to the files that provide it. Lookups never touch the disk.
+ *
+ * The index is persisted in the cache directory and validated against the
+ * modification time of each directory on startup, so only directories that
+ * changed are listed again. The same happens at runtime: icon directories
+ * are watched and iconsChanged() reports the names that were affected.
+ */
+class IconThemeIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum DirectoryType {
+        Fixed = 0,
+        Scalable,
+        Threshold,
+        Fallback
+    };
+
+    struct Directory {
+        QString path;
+        qint64 modified = 0;
+        int depth = 0;
+        int size = 0;
+        int scale = 1;
+        int minSize = 0;
+        int maxSize = 0;
+        int threshold = 2;
+        int type = Threshold;
+    };
+
+    struct Location {
+        int directory = 0;
+        int extension = 0;
+    };
+
+    struct Data {
+        QString themeName;
+        QStringList roots;
+        QStringList themeFiles;
+        QVector<qint64> themeFilesModified;
+        QVector<Directory> directories;
+        QHash<QString, QVector<Location>> icons;
+    };
+
+    static IconThemeIndex *self();
+
+    bool isReady() const;
+    QString themeName() const;
+
+    // Returns the file that best matches the requested size, or an empty
+    // string if the icon is unknown (or the index is not built yet).
+    QString lookup(const QString &name, int size, int scale = 1) const;
+
+    // Rebuilds the index if the icon theme setting changed. Called by the
+    // launcher window on ThemeChange and whenever it is shown.
+    void checkTheme();
+    void rebuild();
+
+signals:
+    void ready();
+    void themeChanged();
+    void iconsChanged(const QStringList &names);
+
+private slots:
+    void updateWatches();
+
+private:
+    explicit IconThemeIndex(QObject *parent = nullptr);
+
+    static void build(IconThemeIndex *index, const QString &themeName,
+                      const QStringList &searchPaths, const QStringList &fallbackPaths);
+    void setData(QSharedPointer<const Data> data);
+    QSharedPointer<const Data> data() const;
+
+private:
+    mutable QMutex m_mutex;
+    QSharedPointer<const Data> m_data;
+
+    QThreadPool m_pool;
+    QFileSystemWatcher *m_watcher;
+    QTimer m_rebuildTimer;
+    QString m_buildThemeName;
+};
+
+#endif // ICONTHEMEINDEX_H
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instanceserver.h"
+#include "launcher.h"
+
+#include <QSocketNotifier>
+#include <QList>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(LAUNCHER_INSTANCE, "cutefish.launcher.instance")
+
+static const char SocketName[] = "cutefish-launcher.socket";
+
+static qint64 monotonicTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static bool socketAddress(sockaddr_un *address)
+{
+    const char *runtimeDir = getenv("XDG_RUNTIME_DIR");
+
+    if (!runtimeDir || !*runtimeDir)
+        return false;
+
+    memset(address, 0, sizeof(sockaddr_un));
+    address->sun_family = AF_UNIX;
+
+    const int length = snprintf(address->sun_path, sizeof(address->sun_path), "%s/%s", runtimeDir, SocketName);
+    return length > 0 && length < int(sizeof(address->sun_path));
+}
+
+bool InstanceServer::forward(const char *command)
+{
+    sockaddr_un address;
+    if (!socketAddress(&address))
+        return false;
+
+    const int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+
+    char message[64];
+    const int length = snprintf(message, sizeof(message), "%s %lld", command, static_cast<long long>(monotonicTime()));
+
+    // Fails with ECONNREFUSED or ENOENT if no launcher is listening.
+    const bool sent = sendto(fd, message, size_t(length), 0,
+                             reinterpret_cast<sockaddr *>(&address), sizeof(address)) == length;
+    close(fd);
+
+    return sent;
+}
+
+InstanceServer::InstanceServer(Launcher *launcher)
+    : QObject(launcher)
+    , m_launcher(launcher)
+    , m_notifier(nullptr)
+    , m_fd(-1)
+{
+    sockaddr_un address;
+    if (!socketAddress(&address))
+        return;
+
+    m_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (m_fd < 0)
+        return;
+
+    // We own the bus name, so a socket left behind is stale.
+    m_path = address.sun_path;
+    unlink(m_path.constData());
+
+    if (bind(m_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        qCWarning(LAUNCHER_INSTANCE) << "Failed to bind" << m_path << strerror(errno);
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &InstanceServer::onActivated);
+}
+
+InstanceServer::~InstanceServer()
+{
+    if (m_fd < 0)
+        return;
+
+    close(m_fd);
+    unlink(m_path.constData());
+}
+
+void InstanceServer::onActivated()
+{
+    char buffer[64];
+    ssize_t length;
+
+    while ((length = recv(m_fd, buffer, sizeof(buffer) - 1, 0)) > 0) {
+        const QList<QByteArray> parts = QByteArray(buffer, int(length)).split(' ');
+        const QByteArray command = parts.value(0);
+        const qint64 startTime = parts.value(1).toLongLong();
+
+        const bool wasVisible = m_launcher->isVisible();
+
+        if (command == "toggle")
+            m_launcher->toggle();
+        else if (command == "show")
+            m_launcher->showWindow();
+        else if (command == "hide")
+            m_launcher->hideWindow();
+        else
+            continue;
+
+        if (!wasVisible && m_launcher->isVisible() && startTime > 0)
+            measureLatency(startTime);
+    }
+}
+
+void InstanceServer::measureLatency(qint64 startTime)
+{
+    m_launcher->afterNextFrame([=] {
+        qCDebug(LAUNCHER_INSTANCE) << "shown" << (monotonicTime() - startTime) / 1000 << "us after the client started";
+    });
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INSTANCESERVER_H
+#define INSTANCESERVER_H
+
+#include <QObject>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(LAUNCHER_INSTANCE)
+
+class QSocketNotifier;
+class Launcher;
+
+/**
+ * Receives show/hide/toggle requests from later launcher processes.
+ *
+ * A second instance calls forward() first thing in main(), before any Qt
+ * object exists: one datagram on a UNIX socket in $XDG_RUNTIME_DIR, no
+ * D-Bus connection and no GUI setup. The datagram carries the monotonic
+ * time the client started, the latency until the first frame after the
+ * window is shown is logged to the "cutefish.launcher.instance" category.
+ */
+class InstanceServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit InstanceServer(Launcher *launcher);
+    ~InstanceServer();
+
+    // Only plain POSIX calls, safe to use before QApplication. Returns
+    // false if no running instance received the command.
+    static bool forward(const char *command);
+
+private slots:
+    void onActivated();
+
+private:
+    void measureLatency(qint64 startTime);
+
+private:
+    Launcher *m_launcher;
+    QSocketNotifier *m_notifier;
+    QByteArray m_path;
+    int m_fd;
+};
+
+#endif // INSTANCESERVER_H
@@ -19,10 +19,17 @@
 
 #include "launcher.h"
 #include "launcheradaptor.h"
+#include "launchermodel.h"
+#include "appindexwriter.h"
 #include "iconthemeimageprovider.h"
+#include "iconthemeindex.h"
+#include "iconcache.h"
+#include "trace.h"
+#include "metrics.h"
 
 #include <QApplication>
 #include <QDBusConnection>
+#include <QDBusMetaType>
 #include <QDBusServiceWatcher>
 #include <QPixmapCache>
 #include <QQmlContext>
@@ -33,18 +40,28 @@
 
 Launcher::Launcher(bool firstShow, QQuickView *w)
     : QQuickView(w)
+    , m_launcherModel(new LauncherModel(this))
     , m_dockInterface("com.cutefish.Dock",
                     "/Dock",
                     "com.cutefish.Dock", QDBusConnection::sessionBus())
     , m_hideTimer(new QTimer)
+    , m_trimTimer(new QTimer(this))
     , m_showed(false)
     , m_leftMargin(0)
     , m_rightMargin(0)
     , m_bottomMargin(0)
 {
+    TRACE_SPAN("Launcher::Launcher");
+
+    qDBusRegisterMetaType<QList<QVariantMap>>();
     new LauncherAdaptor(this);
 
+    connect(m_launcherModel, &LauncherModel::appsChanged, this, &Launcher::AppsChanged);
+    new AppIndexWriter(m_launcherModel, this);
+
     engine()->rootContext()->setContextProperty("launcher", this);
+    engine()->rootContext()->setContextProperty("launcherModel", m_launcherModel);
+    engine()->rootContext()->setContextProperty("iconCache", IconCache::self());
 
     setColor(Qt::transparent);
     setFlags(Qt::FramelessWindowHint);
@@ -62,6 +79,20 @@ Launcher::Launcher(bool firstShow, QQuickView *w)
     m_hideTimer->setSingleShot(true);
     connect(m_hideTimer, &QTimer::timeout, this, [=] { setVisible(false); });
 
+    // Give icon memory back once we have been hidden for a while.
+    m_trimTimer->setInterval(IconCache::self()->trimDelay() * 1000);
+    m_trimTimer->setSingleShot(true);
+    connect(m_trimTimer, &QTimer::timeout, this, [=] {
+        IconCache::self()->trimToLowWatermark();
+        releaseResources();
+    });
+    connect(this, &QWindow::visibleChanged, this, [=] (bool visible) {
+        if (visible)
+            m_trimTimer->stop();
+        else
+            m_trimTimer->start();
+    });
+
     if (m_dockInterface.isValid() && !m_dockInterface.lastError().isValid()) {
         updateMargins();
         connect(&m_dockInterface, SIGNAL(primaryGeometryChanged()), this, SLOT(updateMargins()));
@@ -104,10 +135,24 @@ bool Launcher::showed()
 
 void Launcher::showWindow()
 {
+    TRACE_SPAN("Launcher::showWindow");
+    const qint64 showTime = Trace::now();
+
+    // Not every platform theme sends a ThemeChange event.
+    IconThemeIndex::self()->checkTheme();
+
     m_showed = true;
     emit showedChanged();
 
     setVisible(true);
+
+    afterNextFrame([=] {
+        const qint64 frameTime = Trace::now();
+        Metrics::observe(Metrics::ToggleToFirstFrame, (frameTime - showTime) / 1000);
+
+        if (Trace::isEnabled())
+            Trace::record("Launcher::firstFrame", showTime, frameTime);
+    });
 }
 
 void Launcher::hideWindow()
@@ -127,27 +172,63 @@ bool Launcher::dockAvailable()
     return m_dockInterface.isValid();
 }
 
-bool Launcher::isPinedDock(const QString &desktop)
+void Launcher::clearPixmapCache()
 {
-    QDBusInterface iface("com.cutefish.Dock",
-                         "/Dock",
-                         "com.cutefish.Dock",
-                         QDBusConnection::sessionBus());
+    QPixmapCache::clear();
+}
 
-    if (!iface.isValid())
-        return false;
+QRect Launcher::screenRect()
+{
+    return m_screenRect;
+}
 
-    return iface.call("pinned", desktop).arguments().first().toBool();
+LauncherModel *Launcher::launcherModel() const
+{
+    return m_launcherModel;
 }
 
-void Launcher::clearPixmapCache()
+QList<QVariantMap> Launcher::GetApps(const QStringList &fields)
 {
-    QPixmapCache::clear();
+    return m_launcherModel->apps(fields);
 }
 
-QRect Launcher::screenRect()
+QList<QVariantMap> Launcher::Search(const QString &query, int limit)
 {
-    return m_screenRect;
+    return m_launcherModel->searchApps(query, limit);
+}
+
+bool Launcher::Launch(const QString &id)
+{
+    return m_launcherModel->launch(id);
+}
+
+void Launcher::SetLocale(const QString &locale)
+{
+    m_launcherModel->setLocale(locale);
+}
+
+void Launcher::SetTracing(bool enabled)
+{
+    Trace::setEnabled(enabled);
+}
+
+bool Launcher::DumpTrace(const QString &name)
+{
+    // Any client on the session bus may call this, so it only picks the
+    // name of a file in the runtime directory.
+    const QString fileName = Trace::dumpPath(name);
+    return !fileName.isEmpty() && Trace::dump(fileName);
+}
+
+void Launcher::afterNextFrame(const std::function<void ()> &callback)
+{
+    QMetaObject::Connection *connection = new QMetaObject::Connection;
+
+    *connection = connect(this, &QQuickWindow::frameSwapped, this, [=] {
+        disconnect(*connection);
+        delete connection;
+        callback();
+    }, Qt::DirectConnection);
 }
 
 void Launcher::updateMargins()
@@ -190,6 +271,15 @@ void Launcher::onGeometryChanged()
     connect(screen(), &QScreen::geometryChanged, this, &Launcher::updateSize);
 }
 
+bool Launcher::event(QEvent *e)
+{
+    // Delivered to the window once, not to every object in the process.
+    if (e->type() == QEvent::ThemeChange)
+        IconThemeIndex::self()->checkTheme();
+
+    return QQuickView::event(e);
+}
+
 void Launcher::showEvent(QShowEvent *e)
 {
     KWindowSystem::setState(winId(), NET::SkipTaskbar | NET::SkipPager);
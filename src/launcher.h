@@ -26,6 +26,10 @@
 
 #include <QDBusInterface>
 
+#include <functional>
+
+class LauncherModel;
+
 class Launcher : public QQuickView
 {
     Q_OBJECT
@@ -49,13 +53,28 @@ public:
     Q_INVOKABLE void toggle();
 
     Q_INVOKABLE bool dockAvailable();
-    Q_INVOKABLE bool isPinedDock(const QString &desktop);
 
     Q_INVOKABLE void clearPixmapCache();
 
     QRect screenRect();
 
+    LauncherModel *launcherModel() const;
+
+    // Runs callback on the render thread once the next frame was swapped.
+    void afterNextFrame(const std::function<void ()> &callback);
+
+    // D-Bus API, served from the launcher model so other shell parts
+    // don't have to parse desktop files themselves.
+    Q_INVOKABLE QList<QVariantMap> GetApps(const QStringList &fields);
+    Q_INVOKABLE QList<QVariantMap> Search(const QString &query, int limit);
+    Q_INVOKABLE bool Launch(const QString &id);
+    Q_INVOKABLE void SetLocale(const QString &locale);
+    Q_INVOKABLE void SetTracing(bool enabled);
+    Q_INVOKABLE bool DumpTrace(const QString &name);
+
 signals:
+    void AppsChanged(const QStringList &added, const QStringList &removed, const QStringList &changed);
+
     void screenRectChanged();
     void showedChanged();
     void marginsChanged();
@@ -66,6 +85,7 @@ private slots:
     void onGeometryChanged();
 
 protected:
+    bool event(QEvent *e) override;
     void showEvent(QShowEvent *e) override;
     void resizeEvent(QResizeEvent *e) override;
 
@@ -73,9 +93,11 @@ private:
     void onActiveChanged();
 
 private:
+    LauncherModel *m_launcherModel;
     QDBusInterface m_dockInterface;
     QRect m_screenRect;
     QTimer *m_hideTimer;
+    QTimer *m_trimTimer;
     bool m_showed;
 
     int m_leftMargin;
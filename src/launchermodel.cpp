@@ -19,21 +19,32 @@
 
 #include "launchermodel.h"
 #include "desktopproperties.h"
+#include "exectemplate.h"
+#include "executableresolver.h"
 #include "processprovider.h"
+#include "prewarmer.h"
+#include "trace.h"
+#include "metrics.h"
 
 #include <QDBusInterface>
 #include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
 
 #include <QtConcurrent/QtConcurrentRun>
-#include <QRegularExpression>
 #include <QFileSystemWatcher>
 #include <QStandardPaths>
 #include <QScopedPointer>
 #include <QDirIterator>
+#include <QDateTime>
+#include <QFileInfo>
 #include <QDebug>
 #include <QIcon>
 #include <QDir>
 
+// Pinned states asked from the dock at a time, see requestPinned().
+static const int PinnedBatchSize = 16;
+
 static QByteArray detectDesktopEnvironment()
 {
     const QByteArray desktop = qgetenv("XDG_CURRENT_DESKTOP");
@@ -44,24 +55,153 @@ static QByteArray detectDesktopEnvironment()
     return QByteArray("UNKNOWN");
 }
 
+static QList<QPair<QString, qint64> > actionOffsets(const DesktopProperties &desktop, const QString &actions)
+{
+    QList<QPair<QString, qint64> > offsets;
+
+    for (const QString &action : actions.split(QLatin1Char(';'))) {
+        const qint64 offset = desktop.groupOffset(QStringLiteral("Desktop Action ") + action);
+
+        if (!action.isEmpty() && offset >= 0)
+            offsets.append(qMakePair(action, offset));
+    }
+
+    return offsets;
+}
+
+// LC_MESSAGES as the environment sets it, which keeps the modifier, unless
+// the locale was changed since.
+static QString messagesLocale()
+{
+    const QString system = QLocale::system().name();
+    QString locale;
+
+    for (const char *variable : { "LC_ALL", "LC_MESSAGES", "LANG" }) {
+        locale = QString::fromLocal8Bit(qgetenv(variable));
+        if (!locale.isEmpty())
+            break;
+    }
+
+    const QString name = locale.section(QLatin1Char('@'), 0, 0).section(QLatin1Char('.'), 0, 0);
+    return name == system ? locale : system;
+}
+
+static QMap<QString, QString> translations(const DesktopProperties &desktop)
+{
+    QMap<QString, QString> result = desktop.translations("Name");
+    result.unite(desktop.translations("GenericName"));
+    result.unite(desktop.translations("Comment"));
+    return result;
+}
+
+static QStringList categories(const DesktopProperties &desktop)
+{
+    QStringList result = desktop.value("Categories").toString().split(QLatin1Char(';'));
+    result.removeAll(QString());
+    return result;
+}
+
+static QCollator createCollator(const QLocale &locale)
+{
+    QCollator collator(locale);
+    collator.setNumericMode(true);
+    return collator;
+}
+
 LauncherModel::LauncherModel(QObject *parent)
+    : LauncherModel(QStringLiteral("/usr/share/applications"), parent)
+{
+}
+
+LauncherModel::LauncherModel(const QString &applicationsPath, QObject *parent)
     : QAbstractListModel(parent)
+    , m_applicationsPath(applicationsPath)
     , m_fileWatcher(new QFileSystemWatcher(this))
     , m_settings("cutefishos", "launcher-applist", this)
     , m_mode(NormalMode)
+    , m_searchIndexValid(false)
+    , m_collator(createCollator(QLocale()))
+    , m_locales(DesktopProperties::localeChain(messagesLocale()))
     , m_firstLoad(false)
+    , m_dbusRoundTrips(0)
 {
     // Init datas.
     QByteArray listByteArray = m_settings.value("list").toByteArray();
     QDataStream in(&listByteArray, QIODevice::ReadOnly);
     in >> m_appItems;
 
+    QByteArray modifiedByteArray = m_settings.value("modified").toByteArray();
+    QDataStream modifiedIn(&modifiedByteArray, QIODevice::ReadOnly);
+    modifiedIn >> m_modified;
+
+    // Entries that are not parsed again need their command line.
+    QHash<QString, QStringList> exec;
+    QByteArray execByteArray = m_settings.value("exec").toByteArray();
+    QDataStream execIn(&execByteArray, QIODevice::ReadOnly);
+    execIn >> exec;
+
+    QHash<QString, QString> tryExec;
+    QByteArray tryExecByteArray = m_settings.value("tryExec").toByteArray();
+    QDataStream tryExecIn(&tryExecByteArray, QIODevice::ReadOnly);
+    tryExecIn >> tryExec;
+
+    QHash<QString, QStringList> categories;
+    QByteArray categoriesByteArray = m_settings.value("categories").toByteArray();
+    QDataStream categoriesIn(&categoriesByteArray, QIODevice::ReadOnly);
+    categoriesIn >> categories;
+
+    // Names are resolved again from these when the locale changes.
+    QByteArray translationsByteArray = m_settings.value("translations").toByteArray();
+    QDataStream translationsIn(&translationsByteArray, QIODevice::ReadOnly);
+    translationsIn >> m_translations;
+
+    // Entries hidden for a missing executable, and where they were.
+    QList<AppItem> hidden;
+    QByteArray hiddenByteArray = m_settings.value("hidden").toByteArray();
+    QDataStream hiddenIn(&hiddenByteArray, QIODevice::ReadOnly);
+    hiddenIn >> hidden;
+
+    QHash<QString, int> hiddenRows;
+    QByteArray hiddenRowsByteArray = m_settings.value("hiddenRows").toByteArray();
+    QDataStream hiddenRowsIn(&hiddenRowsByteArray, QIODevice::ReadOnly);
+    hiddenRowsIn >> hiddenRows;
+
+    auto restore = [&] (AppItem &item) {
+        item.exec = ExecTemplate::fromArguments(exec.value(item.id));
+        item.tryExec = tryExec.value(item.id);
+        item.categories = categories.value(item.id);
+
+        if (item.exec.isEmpty())
+            m_modified.remove(item.id);
+    };
+
+    for (AppItem &item : m_appItems)
+        restore(item);
+
+    for (AppItem &item : hidden) {
+        restore(item);
+        MissingApp missing = { item, hiddenRows.value(item.id, -1) };
+        m_missing.insert(item.id, missing);
+    }
+
+    // Names were resolved for the locale they were parsed in.
+    if (m_settings.value("locale").toString() != QLocale().name())
+        m_modified.clear();
+
     if (m_appItems.isEmpty())
         m_firstLoad = true;
 
+    // Keys are not saved, the ones of the saved items come in the background.
+    connect(&m_sortKeyWatcher, &QFutureWatcher<QHash<QString, AppItem::SortKey> >::finished,
+            this, &LauncherModel::applySortKeys);
+    updateSortKeys();
+
+    connect(&m_localizeWatcher, &QFutureWatcher<QHash<QString, Localized> >::finished,
+            this, &LauncherModel::applyLocalized);
+
     QtConcurrent::run(LauncherModel::refresh, this);
 
-    m_fileWatcher->addPath("/usr/share/applications");
+    m_fileWatcher->addPath(m_applicationsPath);
     connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &LauncherModel::onFileChanged);
     connect(m_fileWatcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &) {
         QtConcurrent::run(LauncherModel::refresh, this);
@@ -71,11 +211,41 @@ LauncherModel::LauncherModel(QObject *parent)
     m_saveTimer.setSingleShot(true);
     connect(&m_saveTimer, &QTimer::timeout, this, &LauncherModel::save);
 
+    // A refresh touches many entries at once, report them together.
+    m_appsChangedTimer.setInterval(200);
+    m_appsChangedTimer.setSingleShot(true);
+    connect(&m_appsChangedTimer, &QTimer::timeout, this, &LauncherModel::emitAppsChanged);
+    connect(this, &LauncherModel::pinnedChanged, this, &LauncherModel::queueChanged);
+
+    m_pinnedTimer.setInterval(50);
+    m_pinnedTimer.setSingleShot(true);
+    connect(&m_pinnedTimer, &QTimer::timeout, this, &LauncherModel::sendPinnedQueries);
+
+    // Replies for a search filtering by pinned state come in one by one.
+    m_searchTimer.setInterval(100);
+    m_searchTimer.setSingleShot(true);
+    connect(&m_searchTimer, &QTimer::timeout, this, [this] { search(m_searchKey); });
+
     connect(this, &QAbstractItemModel::rowsInserted, this, &LauncherModel::countChanged);
     connect(this, &QAbstractItemModel::rowsRemoved, this, &LauncherModel::countChanged);
     connect(this, &QAbstractItemModel::modelReset, this, &LauncherModel::countChanged);
     connect(this, &QAbstractItemModel::layoutChanged, this, &LauncherModel::countChanged);
-    connect(this, &LauncherModel::refreshed, this, &LauncherModel::onRefreshed);
+    connect(ExecutableResolver::self(), &ExecutableResolver::changed, this, &LauncherModel::updateMissing);
+
+    // The pinned cache belongs to one dock instance.
+    QDBusServiceWatcher *dockWatcher = new QDBusServiceWatcher("com.cutefish.Dock",
+                                                               QDBusConnection::sessionBus(),
+                                                               QDBusServiceWatcher::WatchForOwnerChange,
+                                                               this);
+    connect(dockWatcher, &QDBusServiceWatcher::serviceOwnerChanged, this,
+            [=] (const QString &, const QString &, const QString &newOwner) {
+        const QSet<QString> pinned = m_pinned;
+        for (const QString &id : pinned)
+            updatePinned(id, false);
+
+        if (!newOwner.isEmpty())
+            reloadPinned();
+    });
 }
 
 LauncherModel::~LauncherModel()
@@ -88,6 +258,11 @@ int LauncherModel::count() const
     return rowCount();
 }
 
+const QList<AppItem> &LauncherModel::items() const
+{
+    return m_appItems;
+}
+
 int LauncherModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
@@ -139,6 +314,11 @@ QVariant LauncherModel::data(const QModelIndex &index, int role) const
                        + appItem.genericName
                        + QStringLiteral(" ")
                        + appItem.comment);
+    case PinnedRole:
+        requestPinned(appItem.id);
+        return m_pinned.contains(appItem.id);
+    case CategoriesRole:
+        return appItem.categories;
     case NewInstalledRole:
         return appItem.newInstalled;
     }
@@ -148,21 +328,31 @@ QVariant LauncherModel::data(const QModelIndex &index, int role) const
 
 void LauncherModel::search(const QString &key)
 {
+    TRACE_SPAN("LauncherModel::search");
+    const qint64 begin = Trace::now();
+
     m_mode = key.isEmpty() ? NormalMode : SearchMode;
+    m_searchKey = key;
     m_searchItems.clear();
 
-    for (const AppItem &item : qAsConst(m_appItems)) {
-        const QString &name = item.name;
-        const QString &fileName = item.id;
+    // Filters narrow the rows down before any text is compared.
+    const SearchQuery query = SearchQuery::parse(key);
 
-        if (name.contains(key, Qt::CaseInsensitive) ||
-                fileName.contains(key, Qt::CaseInsensitive)) {
-            m_searchItems.append(item);
-            continue;
-        }
+    // Filtering by pinned state needs it for every app, not only the
+    // rows shown so far.
+    if ((query.flags | query.excludedFlags) & SearchQuery::Pinned) {
+        for (const AppItem &item : qAsConst(m_appItems))
+            requestPinned(item.id);
     }
+    SearchIndex::forEach(searchIndex().filter(query), [&] (int row) {
+        const AppItem &item = m_appItems.at(row);
+        if (query.matches(item))
+            m_searchItems.append(item);
+    });
 
     emit layoutChanged();
+
+    Metrics::observe(Metrics::SearchLatency, (Trace::now() - begin) / 1000);
 }
 
 void LauncherModel::sendToDock(const QString &key)
@@ -170,12 +360,10 @@ void LauncherModel::sendToDock(const QString &key)
     int index = findById(key);
 
     if (index != -1) {
-        QDBusMessage message = QDBusMessage::createMethodCall("com.cutefish.Dock",
-                                                              "/Dock",
-                                                              "com.cutefish.Dock",
-                                                               "add");
-        message.setArguments(QList<QVariant>() << key);
-        QDBusConnection::sessionBus().asyncCall(message);
+        callDock("add", key);
+        updatePinned(key, true);
+        // Replies come back in order, so this one settles any older query.
+        queryPinned(QStringList() << key);
     }
 }
 
@@ -198,15 +386,56 @@ void LauncherModel::removeFromDock(const QString &desktop)
     int index = findById(desktop);
 
     if (index != -1) {
-        QDBusMessage message = QDBusMessage::createMethodCall("com.cutefish.Dock",
-                                                              "/Dock",
-                                                              "com.cutefish.Dock",
-                                                               "remove");
-        message.setArguments(QList<QVariant>() << desktop);
-        QDBusConnection::sessionBus().asyncCall(message);
+        callDock("remove", desktop);
+        updatePinned(desktop, false);
+        queryPinned(QStringList() << desktop);
     }
 }
 
+bool LauncherModel::isPinned(const QString &id) const
+{
+    return m_pinned.contains(id);
+}
+
+void LauncherModel::revalidatePinned(const QString &id)
+{
+    m_pinnedRequested.insert(id);
+    queryPinned(QStringList() << id);
+}
+
+quint64 LauncherModel::dbusRoundTrips() const
+{
+    return m_dbusRoundTrips;
+}
+
+QList<QVariantMap> LauncherModel::apps(const QStringList &fields) const
+{
+    QList<QVariantMap> result;
+    result.reserve(m_appItems.size());
+
+    for (const AppItem &item : m_appItems)
+        result.append(appData(item, fields));
+
+    return result;
+}
+
+QList<QVariantMap> LauncherModel::searchApps(const QString &key, int limit, const QStringList &fields) const
+{
+    QList<QVariantMap> result;
+
+    const SearchQuery query = SearchQuery::parse(key);
+    SearchIndex::forEach(searchIndex().filter(query), [&] (int row) {
+        if (limit > 0 && result.size() >= limit)
+            return;
+
+        const AppItem &item = m_appItems.at(row);
+        if (query.matches(item))
+            result.append(appData(item, fields));
+    });
+
+    return result;
+}
+
 int LauncherModel::findById(const QString &id)
 {
     for (int i = 0; i < m_appItems.size(); ++i) {
@@ -219,12 +448,17 @@ int LauncherModel::findById(const QString &id)
 
 void LauncherModel::refresh(LauncherModel *manager)
 {
+    TRACE_SPAN("LauncherModel::refresh");
+
+    // Handed to onRefreshed(), refreshes may overlap.
+    const qint64 started = Trace::now();
+
     QStringList addedEntries;
     for (const AppItem &item : qAsConst(manager->m_appItems))
         addedEntries.append(item.id);
 
     QStringList allEntries;
-    QDirIterator it("/usr/share/applications", { "*.desktop" }, QDir::NoFilter, QDirIterator::Subdirectories);
+    QDirIterator it(manager->m_applicationsPath, { "*.desktop" }, QDir::NoFilter, QDirIterator::Subdirectories);
 
     while (it.hasNext()) {
         const auto fileName = it.next();
@@ -243,7 +477,7 @@ void LauncherModel::refresh(LauncherModel *manager)
             QMetaObject::invokeMethod(manager, "removeApp", Q_ARG(QString, item.id));
 
     // Signal the model was refreshed
-    QMetaObject::invokeMethod(manager, "refreshed");
+    QMetaObject::invokeMethod(manager, "onRefreshed", Q_ARG(qint64, started));
 }
 
 void LauncherModel::move(int from, int to, int page, int pageCount)
@@ -255,6 +489,7 @@ void LauncherModel::move(int from, int to, int page, int pageCount)
     int newTo = to + (page * pageCount);
 
     m_appItems.move(newFrom, newTo);
+    m_searchIndexValid = false;
 
 //    if (from < to)
 //        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to + 1);
@@ -266,6 +501,61 @@ void LauncherModel::move(int from, int to, int page, int pageCount)
     delaySave();
 }
 
+QVariantList LauncherModel::actions(const QString &id)
+{
+    QVariantList result;
+
+    for (const AppAction &action : desktopActions(id)) {
+        QVariantMap map;
+        map.insert("id", action.id);
+        map.insert("name", action.name);
+        map.insert("iconName", action.iconName);
+        result.append(map);
+    }
+
+    return result;
+}
+
+bool LauncherModel::launchAction(const QString &id, const QString &action)
+{
+    int index = findById(id);
+
+    if (index == -1)
+        return false;
+
+    for (const AppAction &desktopAction : desktopActions(id)) {
+        if (desktopAction.id != action)
+            continue;
+
+        const AppItem &item = m_appItems.at(index);
+        QStringList args = desktopAction.exec.expand(QStringList(),
+                                                     desktopAction.iconName.isEmpty() ? item.iconName : desktopAction.iconName,
+                                                     item.name, item.id);
+        if (args.isEmpty())
+            return false;
+
+        QString cmd = args.takeFirst();
+
+        Metrics::increment(Metrics::Launches);
+
+        ProcessProvider::self()->launch(cmd, args);
+
+        Q_EMIT applicationLaunched();
+
+        return true;
+    }
+
+    return false;
+}
+
+void LauncherModel::prewarm(const QString &id)
+{
+    int index = findById(id);
+
+    if (index != -1 && !m_appItems.at(index).exec.isEmpty())
+        Prewarmer::self()->prewarm(m_appItems.at(index).exec.program());
+}
+
 void LauncherModel::save()
 {
     m_settings.clear();
@@ -273,6 +563,65 @@ void LauncherModel::save()
     QDataStream out(&datas, QIODevice::WriteOnly);
     out << m_appItems;
     m_settings.setValue("list", datas);
+
+    QByteArray modifiedDatas;
+    QDataStream modifiedOut(&modifiedDatas, QIODevice::WriteOnly);
+    modifiedOut << m_modified;
+    m_settings.setValue("modified", modifiedDatas);
+
+    // Apart from the list, which keeps its format.
+    QHash<QString, QStringList> exec;
+    QHash<QString, QString> tryExec;
+    QHash<QString, QStringList> categories;
+    auto store = [&] (const AppItem &item) {
+        exec.insert(item.id, item.exec.arguments());
+        if (!item.tryExec.isEmpty())
+            tryExec.insert(item.id, item.tryExec);
+        if (!item.categories.isEmpty())
+            categories.insert(item.id, item.categories);
+    };
+
+    for (const AppItem &item : qAsConst(m_appItems))
+        store(item);
+
+    QList<AppItem> hidden;
+    QHash<QString, int> hiddenRows;
+    for (const MissingApp &missing : qAsConst(m_missing)) {
+        store(missing.item);
+        hidden.append(missing.item);
+        hiddenRows.insert(missing.item.id, missing.row);
+    }
+
+    QByteArray hiddenDatas;
+    QDataStream hiddenOut(&hiddenDatas, QIODevice::WriteOnly);
+    hiddenOut << hidden;
+    m_settings.setValue("hidden", hiddenDatas);
+
+    QByteArray hiddenRowsDatas;
+    QDataStream hiddenRowsOut(&hiddenRowsDatas, QIODevice::WriteOnly);
+    hiddenRowsOut << hiddenRows;
+    m_settings.setValue("hiddenRows", hiddenRowsDatas);
+
+    QByteArray execDatas;
+    QDataStream execOut(&execDatas, QIODevice::WriteOnly);
+    execOut << exec;
+    m_settings.setValue("exec", execDatas);
+
+    QByteArray tryExecDatas;
+    QDataStream tryExecOut(&tryExecDatas, QIODevice::WriteOnly);
+    tryExecOut << tryExec;
+    m_settings.setValue("tryExec", tryExecDatas);
+
+    QByteArray categoriesDatas;
+    QDataStream categoriesOut(&categoriesDatas, QIODevice::WriteOnly);
+    categoriesOut << categories;
+    m_settings.setValue("categories", categoriesDatas);
+
+    QByteArray translationsDatas;
+    QDataStream translationsOut(&translationsDatas, QIODevice::WriteOnly);
+    translationsOut << m_translations;
+    m_settings.setValue("translations", translationsDatas);
+    m_settings.setValue("locale", QLocale().name());
 }
 
 void LauncherModel::delaySave()
@@ -283,27 +632,41 @@ void LauncherModel::delaySave()
     m_saveTimer.start();
 }
 
+void LauncherModel::setLocale(const QString &name)
+{
+    // Becomes the default so the rest of the launcher follows.
+    QLocale::setDefault(name.isEmpty() ? QLocale::system() : QLocale(name));
+    updateLocale(name.isEmpty() ? messagesLocale() : name);
+}
+
 bool LauncherModel::launch(const QString &path)
 {
     int index = findById(path);
 
-    if (index != -1) {
+    if (index != -1 && !m_appItems.at(index).exec.isEmpty()) {
         AppItem &item = m_appItems[index];
-        QStringList args = item.args;
+        QStringList args = item.exec.expand(QStringList(), item.iconName, item.name, item.id);
+        if (args.isEmpty())
+            return false;
+
         QString cmd = args.takeFirst();
 
         if (item.newInstalled) {
             item.newInstalled = false;
+            m_searchIndexValid = false;
             emit dataChanged(LauncherModel::index(index), LauncherModel::index(index));
+            queueChanged(item.id);
             delaySave();
         }
 
+        Metrics::increment(Metrics::Launches);
+
         // Because launcher has hidden animation,
         // cutefish-screenshot needs to be processed.
         if (cmd == "cutefish-screenshot") {
-            ProcessProvider::startDetached(cmd, QStringList() << "-d" << "200");
+            ProcessProvider::self()->launch(cmd, QStringList() << "-d" << "200");
         } else {
-            ProcessProvider::startDetached(cmd, args);
+            ProcessProvider::self()->launch(cmd, args);
         }
 
         Q_EMIT applicationLaunched();
@@ -314,57 +677,92 @@ bool LauncherModel::launch(const QString &path)
     return false;
 }
 
-void LauncherModel::onRefreshed()
+void LauncherModel::onRefreshed(qint64 started)
 {
-    if (!m_firstLoad)
-        return;
+    Metrics::observe(Metrics::RefreshDuration, (Trace::now() - started) / 1000);
 
-    m_firstLoad = false;
+    // Entries served from the cache were not checked by addApp().
+    updateMissing();
 
-    beginResetModel();
-    std::sort(m_appItems.begin(), m_appItems.end(), [=] (AppItem &a, AppItem &b) {
-        return a.name < b.name;
-    });
-    endResetModel();
+    if (m_firstLoad) {
+        m_firstLoad = false;
 
-    delaySave();
+        ensureSortKeys();
+
+        beginResetModel();
+        std::sort(m_appItems.begin(), m_appItems.end(), AppItem::lessThan);
+        m_searchIndexValid = false;
+        endResetModel();
+
+        delaySave();
+    }
+
+    emit refreshed();
 }
 
 void LauncherModel::onFileChanged(const QString &path)
 {
+    // Files replaced or deleted are dropped from the watcher.
+    if (!m_fileWatcher->files().contains(path)) {
+        m_watchedFiles.remove(path);
+        if (QFile::exists(path))
+            watchFile(path);
+    }
+
     int index = findById(path);
 
-    if (index == 0) {
+    if (index < 0) {
+        // Hidden entries are kept up to date for when they come back.
+        if (m_missing.contains(path))
+            addApp(path);
         return;
     }
 
     AppItem &item = m_appItems[index];
-    DesktopProperties desktop(item.id, "Desktop Entry");
-    QString appName = desktop.value(QString("Name[%1]").arg(QLocale::system().name())).toString();
-    QString appExec = desktop.value("Exec").toString();
+    DesktopProperties desktop(item.id, "Desktop Entry", m_locales);
+    const QString appName = desktop.localizedValue("Name");
 
     // Update datas.
-    if (appName.isEmpty())
-        appName = desktop.value("Name").toString();
-
-    appExec.remove(QRegularExpression("%."));
-    appExec.remove(QRegularExpression("^\""));
-    appExec = appExec.replace("\"", "");
-    appExec = appExec.simplified();
+    if (item.name != appName)
+        item.sortKey = sortKey(appName);
     item.name = appName;
-    item.genericName = desktop.value("Comment").toString();
-    item.comment = desktop.value("Comment").toString();
+    item.genericName = desktop.localizedValue("GenericName");
+    item.comment = desktop.localizedValue("Comment");
+    m_translations.insert(item.id, translations(desktop));
     item.iconName = desktop.value("Icon").toString();
-    item.args = appExec.split(" ");
+    item.exec = ExecTemplate::parse(desktop.value("Exec").toString());
+    item.tryExec = desktop.value("TryExec").toString();
+    item.categories = categories(desktop);
+    m_searchIndexValid = false;
+    m_actionOffsets.insert(item.id, actionOffsets(desktop, desktop.value("Actions").toString()));
+    m_actions.remove(item.id);
+    m_modified.insert(item.id, QFileInfo(item.id).lastModified().toMSecsSinceEpoch());
+
+    Metrics::increment(Metrics::DesktopFilesParsed);
 
     emit dataChanged(LauncherModel::index(index), LauncherModel::index(index));
+    queueChanged(item.id);
 }
 
 void LauncherModel::addApp(const QString &fileName)
 {
+    TRACE_SPAN("LauncherModel::addApp");
+
     int index = findById(fileName);
+    const bool hidden = m_missing.contains(fileName);
+
+    // Entries we already have are only parsed again if the file changed.
+    const qint64 modified = QFileInfo(fileName).lastModified().toMSecsSinceEpoch();
+    if ((index >= 0 || hidden) && m_modified.value(fileName, -1) == modified) {
+        Metrics::increment(Metrics::DesktopFilesCached);
+        // Cached entries still have to notice edits made from now on.
+        watchFile(fileName);
+        return;
+    }
+
+    Metrics::increment(Metrics::DesktopFilesParsed);
 
-    DesktopProperties desktop(fileName, "Desktop Entry");
+    DesktopProperties desktop(fileName, "Desktop Entry", m_locales);
 
     if (desktop.contains("Terminal") && desktop.value("Terminal").toBool())
         return;
@@ -380,65 +778,583 @@ void LauncherModel::addApp(const QString &fileName)
         desktop.value("Hidden").toBool())
         return;
 
-    QString appName = desktop.value(QString("Name[%1]").arg(QLocale::system().name())).toString();
-    QString appExec = desktop.value("Exec").toString();
-
-    if (appName.isEmpty())
-        appName = desktop.value("Name").toString();
+    const QString appName = desktop.localizedValue("Name");
+    const ExecTemplate exec = ExecTemplate::parse(desktop.value("Exec").toString());
 
-    appExec.remove(QRegularExpression("%."));
-    appExec.remove(QRegularExpression("^\""));
-    // appExec.remove(QRegularExpression(" *$"));
-    appExec = appExec.replace("\"", "");
-    appExec = appExec.simplified();
+    // Hidden until the executable shows up again, see updateMissing().
+    const QString tryExec = desktop.value("TryExec").toString();
+    const QString executable = tryExec.isEmpty() ? exec.program() : tryExec;
+    const bool missing = !executable.isEmpty() && !ExecutableResolver::self()->exists(executable);
 
     // 存在需要更新信息
-    if (index >= 0 && index <= m_appItems.size()) {
-        AppItem &item = m_appItems[index];
+    if (index >= 0 || hidden) {
+        AppItem &item = index >= 0 ? m_appItems[index] : m_missing[fileName].item;
+        const AppItem old = item;
+        if (item.name != appName)
+            item.sortKey = sortKey(appName);
         item.name = appName;
-        item.genericName = desktop.value("Comment").toString();
-        item.comment = desktop.value("Comment").toString();
+        item.genericName = desktop.localizedValue("GenericName");
+        item.comment = desktop.localizedValue("Comment");
         item.iconName = desktop.value("Icon").toString();
-        item.args = appExec.split(" ");
-        emit dataChanged(LauncherModel::index(index), LauncherModel::index(index));
+        item.exec = exec;
+        item.tryExec = tryExec;
+        item.categories = categories(desktop);
+
+        if (index >= 0) {
+            m_searchIndexValid = false;
+            emit dataChanged(LauncherModel::index(index), LauncherModel::index(index));
+
+            if (item.name != old.name || item.genericName != old.genericName
+                    || item.comment != old.comment || item.iconName != old.iconName
+                    || item.exec != old.exec)
+                queueChanged(item.id);
+        }
     } else {
         AppItem appItem;
         appItem.id = fileName;
         appItem.name = appName;
-        appItem.genericName = desktop.value("Comment").toString();
-        appItem.comment = desktop.value("Comment").toString();
+        appItem.genericName = desktop.localizedValue("GenericName");
+        appItem.comment = desktop.localizedValue("Comment");
         appItem.iconName = desktop.value("Icon").toString();
-        appItem.args = appExec.split(" ");
-        appItem.newInstalled = true;
-
-        beginInsertRows(QModelIndex(), m_appItems.count(), m_appItems.count());
-        m_appItems.append(appItem);
-        qDebug() << "added: " << appItem.name << appItem.newInstalled;
-        endInsertRows();
+        appItem.exec = exec;
+        appItem.tryExec = tryExec;
+        appItem.categories = categories(desktop);
+        appItem.sortKey = sortKey(appName);
+        // Everything is new on the first run, none of it is. Neither are
+        // entries that only show up once their executable does.
+        appItem.newInstalled = !m_firstLoad && !missing;
+
+        if (missing) {
+            MissingApp entry = { appItem, -1 };
+            m_missing.insert(fileName, entry);
+        } else {
+            // Goes where it sorts, among apps the user has not moved around.
+            ensureSortKeys();
+            const int row = int(std::upper_bound(m_appItems.constBegin(), m_appItems.constEnd(),
+                                                 appItem, AppItem::lessThan) - m_appItems.constBegin());
+
+            beginInsertRows(QModelIndex(), row, row);
+            m_appItems.insert(row, appItem);
+            m_searchIndexValid = false;
+            qDebug() << "added: " << appItem.name << appItem.newInstalled;
+            endInsertRows();
+
+            queueAdded(appItem.id);
+        }
 
         if (!m_firstLoad) {
             delaySave();
         }
     }
 
+    m_modified.insert(fileName, modified);
+    m_translations.insert(fileName, translations(desktop));
+    m_actionOffsets.insert(fileName, actionOffsets(desktop, desktop.value("Actions").toString()));
+    m_actions.remove(fileName);
+
     // Update desktop files.
-    if (!m_fileWatcher->files().contains(fileName))
-        m_fileWatcher->addPath(fileName);
+    watchFile(fileName);
+
+    if (missing && index >= 0)
+        hideApp(index);
+    else if (!missing && hidden)
+        showApp(fileName);
+}
+
+void LauncherModel::watchFile(const QString &fileName)
+{
+    if (m_watchedFiles.contains(fileName))
+        return;
+
+    m_watchedFiles.insert(fileName);
+    m_fileWatcher->addPath(fileName);
 }
 
 void LauncherModel::removeApp(const QString &fileName)
 {
     int index = findById(fileName);
-    if (index < 0)
+
+    if (index >= 0) {
+        beginRemoveRows(QModelIndex(), index, index);
+        m_appItems.removeAt(index);
+        m_searchIndexValid = false;
+        endRemoveRows();
+
+        queueRemoved(fileName);
+    } else if (!m_missing.remove(fileName)) {
         return;
+    }
+
+    m_modified.remove(fileName);
+    m_actionOffsets.remove(fileName);
+    m_actions.remove(fileName);
+    m_translations.remove(fileName);
+
+    delaySave();
+
+    // Remove
+    if (m_watchedFiles.remove(fileName))
+        m_fileWatcher->removePath(fileName);
+}
+
+void LauncherModel::hideApp(int index)
+{
+    const AppItem item = m_appItems.at(index);
 
     beginRemoveRows(QModelIndex(), index, index);
     m_appItems.removeAt(index);
+    m_searchIndexValid = false;
     endRemoveRows();
 
+    MissingApp missing = { item, index };
+    m_missing.insert(item.id, missing);
+
+    queueRemoved(item.id);
     delaySave();
+}
 
-    // Remove
-    if (m_fileWatcher->files().contains(fileName))
-        m_fileWatcher->removePath(fileName);
+void LauncherModel::showApp(const QString &id)
+{
+    MissingApp missing = m_missing.take(id);
+    AppItem &item = missing.item;
+
+    // The collation may have changed while it was hidden.
+    item.sortKey = sortKey(item.name);
+
+    // Back where it was, or where it sorts if it was never shown.
+    int row = qMin(missing.row, m_appItems.size());
+    if (row < 0) {
+        ensureSortKeys();
+        row = int(std::upper_bound(m_appItems.constBegin(), m_appItems.constEnd(),
+                                   item, AppItem::lessThan) - m_appItems.constBegin());
+    }
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_appItems.insert(row, item);
+    m_searchIndexValid = false;
+    endInsertRows();
+
+    queueAdded(id);
+    delaySave();
+}
+
+void LauncherModel::updateMissing()
+{
+    ExecutableResolver *resolver = ExecutableResolver::self();
+
+    // Backwards, so the rows saved are those of the list as it was.
+    for (int i = m_appItems.size() - 1; i >= 0; --i) {
+        const QString executable = m_appItems.at(i).executable();
+
+        if (!executable.isEmpty() && !resolver->exists(executable))
+            hideApp(i);
+    }
+
+    QStringList deleted;
+    QList<QPair<int, QString> > back;
+    for (auto it = m_missing.constBegin(); it != m_missing.constEnd(); ++it) {
+        if (!QFile::exists(it.key()))
+            deleted.append(it.key());
+        else if (resolver->exists(it->item.executable()))
+            back.append(qMakePair(it->row, it.key()));
+    }
+
+    for (const QString &id : qAsConst(deleted))
+        removeApp(id);
+
+    // In the order of their rows, so each goes back to its own. Entries
+    // never shown have none and go last.
+    std::sort(back.begin(), back.end(), [] (const QPair<int, QString> &a, const QPair<int, QString> &b) {
+        return uint(a.first) < uint(b.first);
+    });
+
+    for (const QPair<int, QString> &entry : qAsConst(back))
+        showApp(entry.second);
+}
+
+void LauncherModel::reloadPinned()
+{
+    // The dock has no call for the whole set, so states are asked for as
+    // rows are shown, see requestPinned().
+    m_pinnedRequested.clear();
+    m_pinnedQueue.clear();
+    m_pinnedTimer.stop();
+
+    if (rowCount() > 0)
+        emit dataChanged(index(0), index(rowCount() - 1), { PinnedRole });
+}
+
+void LauncherModel::requestPinned(const QString &id) const
+{
+    if (m_pinnedRequested.contains(id))
+        return;
+
+    m_pinnedRequested.insert(id);
+    m_pinnedQueue.append(id);
+
+    if (!m_pinnedTimer.isActive())
+        m_pinnedTimer.start();
+}
+
+void LauncherModel::sendPinnedQueries()
+{
+    queryPinned(m_pinnedQueue.mid(0, PinnedBatchSize));
+    m_pinnedQueue = m_pinnedQueue.mid(PinnedBatchSize);
+
+    if (!m_pinnedQueue.isEmpty())
+        m_pinnedTimer.start();
+}
+
+void LauncherModel::queryPinned(const QStringList &ids)
+{
+    if (ids.isEmpty())
+        return;
+
+    // Without blocking. Errors (no dock) simply leave the cache as it is.
+    for (const QString &id : ids) {
+        QDBusMessage message = QDBusMessage::createMethodCall("com.cutefish.Dock",
+                                                              "/Dock",
+                                                              "com.cutefish.Dock",
+                                                              "pinned");
+        message.setArguments(QList<QVariant>() << id);
+
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] (QDBusPendingCallWatcher *call) {
+            QDBusPendingReply<bool> reply = *call;
+
+            if (!reply.isError())
+                updatePinned(id, reply.value());
+
+            call->deleteLater();
+        });
+    }
+
+    m_dbusRoundTrips += ids.size();
+    emit dbusRoundTripsChanged();
+}
+
+void LauncherModel::updatePinned(const QString &id, bool pinned)
+{
+    if (m_pinned.contains(id) == pinned)
+        return;
+
+    if (pinned)
+        m_pinned.insert(id);
+    else
+        m_pinned.remove(id);
+
+    m_searchIndexValid = false;
+
+    const QList<AppItem> &items = m_mode == NormalMode ? m_appItems : m_searchItems;
+    for (int i = 0; i < items.size(); ++i) {
+        if (items.at(i).id == id) {
+            emit dataChanged(LauncherModel::index(i), LauncherModel::index(i), { PinnedRole });
+            break;
+        }
+    }
+
+    if (m_mode == SearchMode) {
+        const SearchQuery query = SearchQuery::parse(m_searchKey);
+        if ((query.flags | query.excludedFlags) & SearchQuery::Pinned)
+            m_searchTimer.start();
+    }
+
+    emit pinnedChanged(id, pinned);
+}
+
+void LauncherModel::callDock(const QString &method, const QString &id)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall("com.cutefish.Dock",
+                                                          "/Dock",
+                                                          "com.cutefish.Dock",
+                                                          method);
+    message.setArguments(QList<QVariant>() << id);
+    QDBusConnection::sessionBus().asyncCall(message);
+
+    ++m_dbusRoundTrips;
+    emit dbusRoundTripsChanged();
+}
+
+QVariantMap LauncherModel::appData(const AppItem &item, const QStringList &fields) const
+{
+    QVariantMap map;
+
+    auto wanted = [&fields] (const char *field) {
+        return fields.isEmpty() || fields.contains(QLatin1String(field));
+    };
+
+    if (wanted("appId"))
+        map.insert("appId", item.id);
+    if (wanted("name"))
+        map.insert("name", item.name);
+    if (wanted("genericName"))
+        map.insert("genericName", item.genericName);
+    if (wanted("comment"))
+        map.insert("comment", item.comment);
+    if (wanted("iconName"))
+        map.insert("iconName", item.iconName);
+    if (wanted("pinned")) {
+        // Changes that come in later are reported by AppsChanged.
+        requestPinned(item.id);
+        map.insert("pinned", m_pinned.contains(item.id));
+    }
+    if (wanted("categories"))
+        map.insert("categories", item.categories);
+    if (wanted("newInstalled"))
+        map.insert("newInstalled", item.newInstalled);
+
+    return map;
+}
+
+const QList<AppAction> &LauncherModel::desktopActions(const QString &id)
+{
+    static const QList<AppAction> none;
+
+    auto it = m_actions.constFind(id);
+    if (it != m_actions.constEnd())
+        return it.value();
+
+    if (findById(id) == -1)
+        return none;
+
+    // Entries served from the cache were not parsed in this session.
+    if (!m_actionOffsets.contains(id)) {
+        DesktopProperties desktop(id, "Desktop Entry");
+        m_actionOffsets.insert(id, actionOffsets(desktop, desktop.value("Actions").toString()));
+    }
+
+    QList<AppAction> actions;
+
+    for (const auto &offset : m_actionOffsets.value(id)) {
+        DesktopProperties group;
+        group.setLocales(m_locales);
+        if (!group.loadGroup(id, offset.second))
+            continue;
+
+        AppAction action;
+        action.id = offset.first;
+        action.name = group.localizedValue("Name");
+        action.iconName = group.value("Icon").toString();
+        action.exec = ExecTemplate::parse(group.value("Exec").toString());
+
+        if (!action.name.isEmpty() && !action.exec.isEmpty())
+            actions.append(action);
+    }
+
+    return m_actions.insert(id, actions).value();
+}
+
+const SearchIndex &LauncherModel::searchIndex() const
+{
+    if (!m_searchIndexValid) {
+        TRACE_SPAN("LauncherModel::searchIndex");
+        m_searchIndex.build(m_appItems, m_pinned);
+        m_searchIndexValid = true;
+    }
+
+    return m_searchIndex;
+}
+
+void LauncherModel::queueAdded(const QString &id)
+{
+    if (m_removedIds.remove(id))
+        m_changedIds.insert(id);
+    else
+        m_addedIds.insert(id);
+
+    m_appsChangedTimer.start();
+}
+
+void LauncherModel::queueRemoved(const QString &id)
+{
+    m_changedIds.remove(id);
+
+    if (!m_addedIds.remove(id))
+        m_removedIds.insert(id);
+
+    m_appsChangedTimer.start();
+}
+
+void LauncherModel::queueChanged(const QString &id)
+{
+    if (!m_addedIds.contains(id))
+        m_changedIds.insert(id);
+
+    m_appsChangedTimer.start();
+}
+
+void LauncherModel::emitAppsChanged()
+{
+    if (m_addedIds.isEmpty() && m_removedIds.isEmpty() && m_changedIds.isEmpty())
+        return;
+
+    emit appsChanged(m_addedIds.values(), m_removedIds.values(), m_changedIds.values());
+
+    m_addedIds.clear();
+    m_removedIds.clear();
+    m_changedIds.clear();
+}
+
+AppItem::SortKey LauncherModel::sortKey(const QString &name) const
+{
+    return AppItem::SortKey(new QCollatorSortKey(m_collator.sortKey(name)));
+}
+
+void LauncherModel::ensureSortKeys()
+{
+    // Items read back from the settings get their key in the background,
+    // until then it is computed here if they have to be compared.
+    for (AppItem &item : m_appItems) {
+        if (!item.sortKey)
+            item.sortKey = sortKey(item.name);
+    }
+}
+
+void LauncherModel::updateSortKeys()
+{
+    m_collator = createCollator(QLocale());
+    m_sortKeyWatcher.setFuture(QtConcurrent::run(LauncherModel::sortKeys, QLocale(), m_appItems));
+}
+
+void LauncherModel::applySortKeys()
+{
+    if (m_sortKeyWatcher.future().resultCount() == 0)
+        return;
+
+    const QHash<QString, AppItem::SortKey> keys = m_sortKeyWatcher.result();
+    ensureSortKeys();
+
+    // Only sort again if the apps were sorted, they may have been arranged
+    // by hand.
+    const bool sorted = std::is_sorted(m_appItems.constBegin(), m_appItems.constEnd(), AppItem::lessThan);
+
+    // Names that changed meanwhile already have a key for the new locale.
+    for (AppItem &item : m_appItems) {
+        auto it = keys.constFind(item.name);
+        if (it != keys.constEnd())
+            item.sortKey = it.value();
+    }
+
+    if (!sorted || std::is_sorted(m_appItems.constBegin(), m_appItems.constEnd(), AppItem::lessThan))
+        return;
+
+    emit layoutAboutToBeChanged();
+    std::stable_sort(m_appItems.begin(), m_appItems.end(), AppItem::lessThan);
+    m_searchIndexValid = false;
+    emit layoutChanged();
+
+    delaySave();
+}
+
+QHash<QString, AppItem::SortKey> LauncherModel::sortKeys(const QLocale &locale, const QList<AppItem> &items)
+{
+    TRACE_SPAN("LauncherModel::sortKeys");
+
+    // QCollator is not shared between threads.
+    const QCollator collator = createCollator(locale);
+    QHash<QString, AppItem::SortKey> keys;
+    keys.reserve(items.size());
+
+    for (const AppItem &item : items) {
+        if (!keys.contains(item.name))
+            keys.insert(item.name, AppItem::SortKey(new QCollatorSortKey(collator.sortKey(item.name))));
+    }
+
+    return keys;
+}
+
+void LauncherModel::updateLocale(const QString &name)
+{
+    const QStringList locales = DesktopProperties::localeChain(name);
+
+    if (locales == m_locales) {
+        updateSortKeys();
+        return;
+    }
+
+    m_locales = locales;
+
+    // Only entries saved before translations were are read again.
+    QStringList unread;
+    for (const AppItem &item : qAsConst(m_appItems)) {
+        if (!m_translations.contains(item.id))
+            unread.append(item.id);
+    }
+    for (const MissingApp &missing : qAsConst(m_missing)) {
+        if (!m_translations.contains(missing.item.id))
+            unread.append(missing.item.id);
+    }
+
+    m_localizeWatcher.setFuture(QtConcurrent::run(LauncherModel::localize, locales, m_translations, unread));
+}
+
+void LauncherModel::applyLocalized()
+{
+    if (m_localizeWatcher.future().resultCount() == 0)
+        return;
+
+    const QHash<QString, Localized> localized = m_localizeWatcher.result();
+
+    for (int i = 0; i < m_appItems.size(); ++i) {
+        AppItem &item = m_appItems[i];
+        auto it = localized.constFind(item.id);
+        if (it == localized.constEnd())
+            continue;
+
+        m_translations.insert(item.id, it->translations);
+
+        if (item.name == it->name && item.genericName == it->genericName && item.comment == it->comment)
+            continue;
+
+        item.name = it->name;
+        item.genericName = it->genericName;
+        item.comment = it->comment;
+
+        emit dataChanged(index(i), index(i));
+        queueChanged(item.id);
+    }
+
+    // Hidden entries get their sort key again when they are shown.
+    for (MissingApp &missing : m_missing) {
+        auto it = localized.constFind(missing.item.id);
+        if (it == localized.constEnd())
+            continue;
+
+        m_translations.insert(missing.item.id, it->translations);
+        missing.item.name = it->name;
+        missing.item.genericName = it->genericName;
+        missing.item.comment = it->comment;
+    }
+
+    // The names changed, and the collation may have as well.
+    updateSortKeys();
+    delaySave();
+}
+
+QHash<QString, LauncherModel::Localized> LauncherModel::localize(const QStringList &locales,
+                                                                 const QHash<QString, QMap<QString, QString> > &translations,
+                                                                 const QStringList &unread)
+{
+    TRACE_SPAN("LauncherModel::localize");
+
+    QHash<QString, Localized> result;
+    result.reserve(translations.size() + unread.size());
+
+    auto resolve = [&] (const QString &id, const QMap<QString, QString> &values) {
+        Localized &entry = result[id];
+        entry.translations = values;
+        entry.name = DesktopProperties::localized(values, "Name", locales);
+        entry.genericName = DesktopProperties::localized(values, "GenericName", locales);
+        entry.comment = DesktopProperties::localized(values, "Comment", locales);
+    };
+
+    for (auto it = translations.constBegin(); it != translations.constEnd(); ++it)
+        resolve(it.key(), it.value());
+
+    for (const QString &id : unread) {
+        DesktopProperties desktop(id, "Desktop Entry");
+        resolve(id, ::translations(desktop));
+    }
+
+    return result;
 }
@@ -24,15 +24,20 @@
 #include <QFileSystemWatcher>
 #include <QLoggingCategory>
 #include <QAbstractListModel>
+#include <QFutureWatcher>
+#include <QCollator>
 #include <QSettings>
 #include <QTimer>
+#include <QSet>
 
 #include "appitem.h"
+#include "searchquery.h"
 
 class LauncherModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(quint64 dbusRoundTrips READ dbusRoundTrips NOTIFY dbusRoundTripsChanged)
 
 public:
     enum Roles {
@@ -57,9 +62,12 @@ public:
     Q_ENUM(Mode)
 
     explicit LauncherModel(QObject *parent = nullptr);
+    // Reads desktop files from another directory, used by the benchmarks.
+    explicit LauncherModel(const QString &applicationsPath, QObject *parent = nullptr);
     ~LauncherModel();
 
     int count() const;
+    const QList<AppItem> &items() const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QHash<int, QByteArray> roleNames() const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
@@ -69,10 +77,30 @@ public:
     Q_INVOKABLE void sendToDesktop(const QString &key);
     Q_INVOKABLE void removeFromDock(const QString &desktop);
 
+    // Answered from the pinned cache, revalidatePinned() asks the dock
+    // again without waiting and reports differences through pinnedChanged().
+    Q_INVOKABLE bool isPinned(const QString &id) const;
+    Q_INVOKABLE void revalidatePinned(const QString &id);
+
+    quint64 dbusRoundTrips() const;
+
+    // Plain data for the D-Bus API. Field names are the role names, an
+    // empty list selects all of them.
+    QList<QVariantMap> apps(const QStringList &fields = QStringList()) const;
+    QList<QVariantMap> searchApps(const QString &key, int limit, const QStringList &fields = QStringList()) const;
+
     int findById(const QString &id);
 
     static void refresh(LauncherModel *manager);
 
+    // The [Desktop Action] groups listed by Actions, as maps with id, name
+    // and iconName. Read the first time they are asked for.
+    Q_INVOKABLE QVariantList actions(const QString &id);
+    Q_INVOKABLE bool launchAction(const QString &id, const QString &action);
+
+    // Reads the application ahead in the background, see Prewarmer.
+    Q_INVOKABLE void prewarm(const QString &id);
+
     Q_INVOKABLE void move(int from, int to, int page, int pageCount);
     Q_INVOKABLE void save();
 
@@ -82,28 +110,132 @@ public Q_SLOTS:
     Q_INVOKABLE bool launch(const QString &path);
     Q_INVOKABLE bool launch() { return launch(QString()); }
 
+    // Switches names and sort order to locale, e.g. "de_DE", or back to
+    // the one of the environment if it is empty. Called when the language
+    // is changed, Qt sends no LocaleChange for that on Linux.
+    void setLocale(const QString &name);
+
 Q_SIGNALS:
     void countChanged();
     void refreshed();
     void applicationLaunched();
+    void pinnedChanged(const QString &id, bool pinned);
+    void dbusRoundTripsChanged();
+    // Batched, ids that were added, removed or whose data changed.
+    void appsChanged(const QStringList &added, const QStringList &removed, const QStringList &changed);
 
 private Q_SLOTS:
-    void onRefreshed();
+    // Queued by refresh(), started is when it began.
+    void onRefreshed(qint64 started);
     void onFileChanged(const QString &path);
     void addApp(const QString &fileName);
     void removeApp(const QString &fileName);
+    void updateMissing();
+
+private:
+    void watchFile(const QString &fileName);
+    void hideApp(int index);
+    void showApp(const QString &id);
+    void reloadPinned();
+    // Queues a query for the pinned state of id, once per dock instance.
+    void requestPinned(const QString &id) const;
+    void sendPinnedQueries();
+    void queryPinned(const QStringList &ids);
+    void updatePinned(const QString &id, bool pinned);
+    void callDock(const QString &method, const QString &id);
+
+    QVariantMap appData(const AppItem &item, const QStringList &fields) const;
+    const QList<AppAction> &desktopActions(const QString &id);
+    const SearchIndex &searchIndex() const;
+
+    void queueAdded(const QString &id);
+    void queueRemoved(const QString &id);
+    void queueChanged(const QString &id);
+    void emitAppsChanged();
+
+    AppItem::SortKey sortKey(const QString &name) const;
+    void updateSortKeys();
+    void applySortKeys();
+    void ensureSortKeys();
+    static QHash<QString, AppItem::SortKey> sortKeys(const QLocale &locale, const QList<AppItem> &items);
+
+    // An entry hidden while its executable is missing, and the row it was
+    // taken from, -1 if it was never shown.
+    struct MissingApp {
+        AppItem item;
+        int row;
+    };
+
+    // Names of an entry resolved for m_locales, and the translations they
+    // were resolved from.
+    struct Localized {
+        QMap<QString, QString> translations;
+        QString name;
+        QString genericName;
+        QString comment;
+    };
+
+    // name is the messages locale, see DesktopProperties::localeChain().
+    void updateLocale(const QString &name);
+    void applyLocalized();
+    static QHash<QString, Localized> localize(const QStringList &locales,
+                                              const QHash<QString, QMap<QString, QString> > &translations,
+                                              const QStringList &unread);
 
 private:
+    QString m_applicationsPath;
     QList<AppItem> m_appItems;
     QList<AppItem> m_searchItems;
 
     QFileSystemWatcher *m_fileWatcher;
+    // Desktop files added to m_fileWatcher.
+    QSet<QString> m_watchedFiles;
 
     QTimer m_saveTimer;
+    QTimer m_appsChangedTimer;
+    // Runs the last search again once pinned states it filters by arrive.
+    QString m_searchKey;
+    QTimer m_searchTimer;
+    QSet<QString> m_addedIds;
+    QSet<QString> m_removedIds;
+    QSet<QString> m_changedIds;
     QSettings m_settings;
     Mode m_mode;
 
+    // Flag and category bitsets over m_appItems, built again on the next
+    // search once m_appItems or m_pinned changed.
+    mutable SearchIndex m_searchIndex;
+    mutable bool m_searchIndexValid;
+
+    QCollator m_collator;
+    QFutureWatcher<QHash<QString, AppItem::SortKey> > m_sortKeyWatcher;
+
+    // Locale fallback chain for localized keys, and the translations of
+    // Name, GenericName and Comment of each entry, saved with the list.
+    QStringList m_locales;
+    QHash<QString, QMap<QString, QString> > m_translations;
+    QFutureWatcher<QHash<QString, Localized> > m_localizeWatcher;
+
     bool m_firstLoad;
+
+    // Modification time of each desktop file when it was last parsed.
+    QHash<QString, qint64> m_modified;
+    // Desktop files hidden because their executable is missing. They stay
+    // watched and in m_modified, and are saved with the list.
+    QHash<QString, MissingApp> m_missing;
+
+    // Where the action groups of each entry start in its desktop file,
+    // recorded while parsing, and the actions read from there.
+    QHash<QString, QList<QPair<QString, qint64> > > m_actionOffsets;
+    QHash<QString, QList<AppAction> > m_actions;
+
+    QSet<QString> m_pinned;
+    // Ids whose pinned state was asked for since the dock started, and the
+    // ones not sent yet.
+    mutable QSet<QString> m_pinnedRequested;
+    mutable QStringList m_pinnedQueue;
+    mutable QTimer m_pinnedTimer;
+    quint64 m_dbusRoundTrips;
 };
 
 #endif // LAUNCHERMODEL_H
@@ -19,7 +19,7 @@
 
 #include <QApplication>
 #include <QDBusConnection>
-#include <QDBusInterface>
+#include <QDBusMessage>
 #include <QPixmapCache>
 #include <QCommandLineOption>
 #include <QCommandLineParser>
@@ -28,7 +28,13 @@
 #include "launchermodel.h"
 #include "pagemodel.h"
 #include "iconitem.h"
+#include "iconthemeindex.h"
+#include "iconcache.h"
+#include "blurredwallpaper.h"
 #include "appmanager.h"
+#include "instanceserver.h"
+#include "trace.h"
+#include "metrics.h"
 
 #include <QDebug>
 #include <QTranslator>
@@ -37,9 +43,15 @@
 #define DBUS_NAME "com.cutefish.Launcher"
 #define DBUS_PATH "/Launcher"
 #define DBUS_INTERFACE "com.cutefish.Launcher"
+#define DBUS_METRICS_PATH "/Metrics"
 
 int main(int argc, char *argv[])
 {
+    // A hotkey press starts a new process, hand the toggle to the running
+    // launcher before paying for any GUI initialization.
+    if (InstanceServer::forward("toggle"))
+        return -1;
+
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 
     QByteArray uri = "Cutefish.Launcher";
@@ -47,6 +59,7 @@ int main(int argc, char *argv[])
     qmlRegisterType<PageModel>(uri, 1, 0, "PageModel");
     qmlRegisterType<IconItem>(uri, 1, 0, "IconItem");
     qmlRegisterType<AppManager>(uri, 1, 0, "AppManager");
+    qmlRegisterType<BlurredWallpaper>(uri, 1, 0, "BlurredWallpaper");
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
     qmlRegisterType<QAbstractItemModel>();
@@ -57,6 +70,10 @@ int main(int argc, char *argv[])
     QApplication app(argc, argv);
     app.setApplicationName(QStringLiteral("cutefish-launcher"));
 
+    Trace::initialize();
+
+    // Rendered icons are kept by IconCache, QPixmapCache only holds the
+    // transient QIcon renders.
     QPixmapCache::setCacheLimit(2048);
 
     QCommandLineParser parser;
@@ -70,11 +87,16 @@ int main(int argc, char *argv[])
 
     QDBusConnection dbus = QDBusConnection::sessionBus();
     if (!dbus.registerService(DBUS_NAME)) {
-        QDBusInterface iface(DBUS_NAME, DBUS_PATH, DBUS_INTERFACE, dbus);
-        iface.call("toggle");
+        // The running launcher has no socket (e.g. it is still starting up),
+        // a plain message avoids the introspection of QDBusInterface.
+        dbus.call(QDBusMessage::createMethodCall(DBUS_NAME, DBUS_PATH, DBUS_INTERFACE, "toggle"));
         return -1;
     }
 
+    // Start indexing the icon theme while the rest of the UI is set up.
+    IconThemeIndex::self();
+    IconCache::self();
+
     QLocale locale;
     QString qmFilePath = QString("%1/%2.qm").arg("/usr/share/cutefish-launcher/translations/").arg(locale.name());
     if (QFile::exists(qmFilePath)) {
@@ -92,5 +114,9 @@ int main(int argc, char *argv[])
     if (!dbus.registerObject(DBUS_PATH, DBUS_INTERFACE, &launcher))
         return -1;
 
+    new InstanceServer(&launcher);
+
+    dbus.registerObject(DBUS_METRICS_PATH, Metrics::self());
+
     return app.exec();
 }
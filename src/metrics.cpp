@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics.h"
+#include "metricsadaptor.h"
+
+#include <QAtomicInteger>
+
+// Upper bounds in microseconds, the last bucket takes everything above.
+static const qint64 Bounds[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000
+};
+static const int BucketCount = sizeof(Bounds) / sizeof(Bounds[0]) + 1;
+
+static const char *const CounterNames[Metrics::CounterCount] = {
+    "desktopFilesParsed",
+    "desktopFilesCached",
+    "iconCacheHits",
+    "iconCacheMisses",
+    "textureUploads",
+    "launches"
+};
+
+static const char *const HistogramNames[Metrics::HistogramCount] = {
+    "toggleToFirstFrame",
+    "searchLatency",
+    "refreshDuration"
+};
+
+struct HistogramData {
+    QAtomicInteger<quint64> buckets[BucketCount];
+    QAtomicInteger<quint64> count;
+    QAtomicInteger<quint64> sum;
+};
+
+static QAtomicInteger<quint64> s_counters[Metrics::CounterCount];
+static HistogramData s_histograms[Metrics::HistogramCount];
+
+Metrics *Metrics::self()
+{
+    static Metrics *s_self = new Metrics;
+    return s_self;
+}
+
+Metrics::Metrics(QObject *parent)
+    : QObject(parent)
+{
+    new MetricsAdaptor(this);
+}
+
+void Metrics::increment(Counter counter, quint64 value)
+{
+    s_counters[counter].fetchAndAddRelaxed(value);
+}
+
+void Metrics::observe(Histogram histogram, qint64 microseconds)
+{
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && microseconds > Bounds[bucket])
+        ++bucket;
+
+    HistogramData &data = s_histograms[histogram];
+    data.buckets[bucket].fetchAndAddRelaxed(1);
+    data.count.fetchAndAddRelaxed(1);
+    data.sum.fetchAndAddRelaxed(quint64(qMax<qint64>(microseconds, 0)));
+}
+
+QVariantMap Metrics::Counters() const
+{
+    QVariantMap counters;
+
+    for (int i = 0; i < CounterCount; ++i)
+        counters.insert(CounterNames[i], s_counters[i].loadAcquire());
+
+    const quint64 hits = s_counters[IconCacheHits].loadAcquire();
+    const quint64 lookups = hits + s_counters[IconCacheMisses].loadAcquire();
+    counters.insert("iconCacheHitRatio", lookups ? double(hits) / lookups : 0.0);
+
+    return counters;
+}
+
+QVariantMap Metrics::Histograms() const
+{
+    QVariantList bounds;
+    for (qint64 bound : Bounds)
+        bounds.append(bound);
+
+    QVariantMap histograms;
+
+    for (int i = 0; i < HistogramCount; ++i) {
+        const HistogramData &data = s_histograms[i];
+
+        QVariantList buckets;
+        for (int bucket = 0; bucket < BucketCount; ++bucket)
+            buckets.append(data.buckets[bucket].loadAcquire());
+
+        QVariantMap histogram;
+        histogram.insert("bounds", bounds);
+        histogram.insert("buckets", buckets);
+        histogram.insert("count", data.count.loadAcquire());
+        histogram.insert("sum", data.sum.loadAcquire());
+        histograms.insert(HistogramNames[i], histogram);
+    }
+
+    return histograms;
+}
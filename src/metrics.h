@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QObject>
+#include <QVariantMap>
+
+/**
+ * Process-wide counters and latency histograms, exported on D-Bus as
+ * com.cutefish.Launcher.Metrics at /Metrics.
+ *
+ * increment() and observe() are a relaxed atomic add each and can be
+ * called from any thread. Histograms have fixed buckets in microseconds.
+ */
+class Metrics : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Counter {
+        DesktopFilesParsed = 0,
+        DesktopFilesCached,
+        IconCacheHits,
+        IconCacheMisses,
+        TextureUploads,
+        Launches,
+        CounterCount
+    };
+
+    enum Histogram {
+        ToggleToFirstFrame = 0,
+        SearchLatency,
+        RefreshDuration,
+        HistogramCount
+    };
+
+    static Metrics *self();
+
+    static void increment(Counter counter, quint64 value = 1);
+    static void observe(Histogram histogram, qint64 microseconds);
+
+    Q_INVOKABLE QVariantMap Counters() const;
+    Q_INVOKABLE QVariantMap Histograms() const;
+
+private:
+    explicit Metrics(QObject *parent = nullptr);
+};
+
+#endif // METRICS_H
@@ -22,15 +22,75 @@
 #include <QtCore/QtGlobal>
 
 PageModel::PageModel(QObject *parent)
-    : QSortFilterProxyModel(parent)
+    : QAbstractProxyModel(parent)
 {
 }
 
-bool PageModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+void PageModel::setSourceModel(QAbstractItemModel *sourceModel)
 {
-    Q_UNUSED(sourceParent);
+    if (this->sourceModel())
+        disconnect(this->sourceModel(), nullptr, this, nullptr);
 
-    return sourceRow >= m_startIndex && sourceRow < m_startIndex + m_limitCount;
+    beginResetModel();
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    m_rowCount = 0;
+    endResetModel();
+
+    if (sourceModel) {
+        // Any structural change just shifts the window, the page keeps its rows.
+        connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &PageModel::sync);
+        connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &PageModel::sync);
+        connect(sourceModel, &QAbstractItemModel::rowsMoved, this, &PageModel::sync);
+        connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &PageModel::sync);
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, &PageModel::sync);
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this, &PageModel::onSourceDataChanged);
+    }
+
+    sync();
+}
+
+QModelIndex PageModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= m_rowCount || column < 0 || column >= columnCount())
+        return QModelIndex();
+
+    return createIndex(row, column);
+}
+
+QModelIndex PageModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child);
+
+    return QModelIndex();
+}
+
+int PageModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int PageModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel())
+        return 0;
+
+    return sourceModel()->columnCount();
+}
+
+QModelIndex PageModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || !sourceModel())
+        return QModelIndex();
+
+    return sourceModel()->index(proxyIndex.row() + m_startIndex, proxyIndex.column());
+}
+
+QModelIndex PageModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid() || sourceIndex.model() != sourceModel())
+        return QModelIndex();
+
+    return index(sourceIndex.row() - m_startIndex, sourceIndex.column());
 }
 
 int PageModel::startIndex() const { return m_startIndex; }
@@ -54,7 +114,7 @@ void PageModel::setStartIndex(int startIndex)
 {
     if (startIndex != m_startIndex) {
         m_startIndex = startIndex;
-        invalidateFilter();
+        sync();
         Q_EMIT startIndexChanged();
     }
 }
@@ -63,7 +123,37 @@ void PageModel::setLimitCount(int limitCount)
 {
     if (limitCount != m_limitCount) {
         m_limitCount = limitCount;
-        invalidateFilter();
+        sync();
         Q_EMIT limitCountChanged();
     }
 }
+
+void PageModel::sync()
+{
+    const int sourceCount = sourceModel() ? sourceModel()->rowCount() : 0;
+    const int count = qBound(0, sourceCount - m_startIndex, m_limitCount);
+    const int unchanged = qMin(count, m_rowCount);
+
+    if (count > m_rowCount) {
+        beginInsertRows(QModelIndex(), m_rowCount, count - 1);
+        m_rowCount = count;
+        endInsertRows();
+    } else if (count < m_rowCount) {
+        beginRemoveRows(QModelIndex(), count, m_rowCount - 1);
+        m_rowCount = count;
+        endRemoveRows();
+    }
+
+    if (unchanged > 0)
+        Q_EMIT dataChanged(index(0, 0), index(unchanged - 1, columnCount() - 1));
+}
+
+void PageModel::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                                    const QVector<int> &roles)
+{
+    const int first = qMax(topLeft.row() - m_startIndex, 0);
+    const int last = qMin(bottomRight.row() - m_startIndex, m_rowCount - 1);
+
+    if (first <= last)
+        Q_EMIT dataChanged(index(first, topLeft.column()), index(last, bottomRight.column()), roles);
+}
@@ -20,14 +20,16 @@
 #ifndef PAGEMODEL_H
 #define PAGEMODEL_H
 
-#include <QtCore/QSortFilterProxyModel>
-#include <QtQml/QQmlComponent>
+#include <QtCore/QAbstractProxyModel>
 
 /**
  * Provides a simple proxy model for accessing a subset, or "page," of data from a source model.
  * This is used by PagedGrid to provide models to each page with the appropriate subset of data.
+ *
+ * Moving the page keeps the rows and only reports their data as changed, so a page
+ * that AllAppsView recycles for another page index keeps its delegates.
  */
-class PageModel : public QSortFilterProxyModel
+class PageModel : public QAbstractProxyModel
 {
     Q_OBJECT
     Q_PROPERTY(int startIndex READ startIndex WRITE setStartIndex NOTIFY startIndexChanged)
@@ -41,7 +43,15 @@ public:
 
     Q_INVOKABLE void move(int from, int to);
 
-    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
 
 public Q_SLOTS:
     void setStartIndex(int startIndex);
@@ -51,9 +61,15 @@ Q_SIGNALS:
     void startIndexChanged();
     void limitCountChanged();
 
+private Q_SLOTS:
+    void sync();
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight,
+                             const QVector<int> &roles);
+
 private:
     int m_startIndex = 0;
     int m_limitCount = 0;
+    int m_rowCount = 0;
 };
 
 #endif // PAGEMODEL_H
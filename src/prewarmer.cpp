@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "prewarmer.h"
+#include "executableresolver.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QFile>
+#include <QDir>
+
+#include <climits>
+#include <cstring>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Pressing the same icon again shortly after is already warm.
+static const qint64 RecentInterval = 60 * 1000;
+
+static void adviseWillNeed(const QString &fileName)
+{
+    const int fd = ::open(QFile::encodeName(fileName).constData(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return;
+
+    // Starts asynchronous readahead of the whole file.
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+}
+
+// Whether [offset, offset + length) lies within size bytes, without
+// overflowing on values read from the file.
+static bool inRange(quint64 offset, quint64 length, quint64 size)
+{
+    return offset <= size && length <= size - offset;
+}
+
+template <typename Ehdr, typename Phdr, typename Dyn>
+static void readDynamic(const uchar *data, qint64 fileSize, QStringList *needed, QStringList *runPath)
+{
+    // Everything below comes from an arbitrary file in $PATH, so offsets
+    // and sizes are checked as unsigned 64-bit values.
+    const quint64 size = quint64(fileSize);
+
+    if (size < sizeof(Ehdr))
+        return;
+
+    const Ehdr *ehdr = reinterpret_cast<const Ehdr *>(data);
+    const quint64 phoff = ehdr->e_phoff;
+    const quint64 phnum = ehdr->e_phnum;
+
+    if (ehdr->e_phentsize != sizeof(Phdr) || phoff % alignof(Phdr) != 0
+            || !inRange(phoff, phnum * sizeof(Phdr), size))
+        return;
+
+    const Phdr *phdrs = reinterpret_cast<const Phdr *>(data + phoff);
+
+    // Dynamic entries hold virtual addresses, map them back to the file.
+    // -1 unless the result lies within the file.
+    auto fileOffset = [&] (quint64 address) -> qint64 {
+        for (quint64 i = 0; i < phnum; ++i) {
+            const Phdr &phdr = phdrs[i];
+            if (phdr.p_type != PT_LOAD || address < phdr.p_vaddr)
+                continue;
+
+            const quint64 delta = address - phdr.p_vaddr;
+            if (delta >= phdr.p_filesz)
+                continue;
+
+            return inRange(phdr.p_offset, delta + 1, size) ? qint64(phdr.p_offset + delta) : -1;
+        }
+        return -1;
+    };
+
+    const Dyn *dynamic = nullptr;
+    quint64 dynamicCount = 0;
+
+    for (quint64 i = 0; i < phnum; ++i) {
+        const Phdr &phdr = phdrs[i];
+        if (phdr.p_type == PT_DYNAMIC && phdr.p_offset % alignof(Dyn) == 0
+                && inRange(phdr.p_offset, phdr.p_filesz, size)) {
+            dynamic = reinterpret_cast<const Dyn *>(data + phdr.p_offset);
+            dynamicCount = phdr.p_filesz / sizeof(Dyn);
+            break;
+        }
+    }
+
+    if (!dynamic)
+        return;
+
+    qint64 stringTable = -1;
+    quint64 stringTableSize = 0;
+
+    for (quint64 i = 0; i < dynamicCount && dynamic[i].d_tag != DT_NULL; ++i) {
+        if (dynamic[i].d_tag == DT_STRTAB)
+            stringTable = fileOffset(dynamic[i].d_un.d_ptr);
+        else if (dynamic[i].d_tag == DT_STRSZ)
+            stringTableSize = quint64(dynamic[i].d_un.d_val);
+    }
+
+    if (stringTable < 0 || !inRange(quint64(stringTable), stringTableSize, size))
+        return;
+
+    const char *strings = reinterpret_cast<const char *>(data + stringTable);
+
+    for (quint64 i = 0; i < dynamicCount && dynamic[i].d_tag != DT_NULL; ++i) {
+        const qint64 tag = qint64(dynamic[i].d_tag);
+        const quint64 offset = quint64(dynamic[i].d_un.d_val);
+
+        if ((tag != DT_NEEDED && tag != DT_RUNPATH && tag != DT_RPATH) || offset >= stringTableSize)
+            continue;
+
+        const uint maxLength = uint(qMin<quint64>(stringTableSize - offset, INT_MAX));
+        const QString value = QFile::decodeName(QByteArray(strings + offset,
+                                                           int(qstrnlen(strings + offset, maxLength))));
+
+        if (tag == DT_NEEDED)
+            needed->append(value);
+        else
+            *runPath += value.split(':');
+    }
+}
+
+// What a wrapper script most likely runs: its interpreter, the programs it
+// exec's and a binary next to it named like the script with a .bin or -bin
+// suffix (soffice and soffice.bin, for the libreoffice wrapper). Variables
+// are not expanded, "$dir/prog" is looked for next to the script.
+static QStringList scriptTargets(const uchar *data, qint64 size, const QString &fileName)
+{
+    const QFileInfo info(fileName);
+    const QDir directory = info.absoluteDir();
+    QStringList targets;
+
+    auto resolve = [&] (QString program) {
+        program.remove(QLatin1Char('"'));
+        program.remove(QLatin1Char('\''));
+
+        if (program.isEmpty())
+            return;
+
+        QString target;
+        if (program.contains(QLatin1Char('$')))
+            target = directory.filePath(program.section(QLatin1Char('/'), -1));
+        else if (program.contains(QLatin1Char('/')))
+            target = directory.absoluteFilePath(program);
+        else
+            target = QStandardPaths::findExecutable(program);
+
+        if (!target.isEmpty() && !targets.contains(target) && QFileInfo(target).isFile())
+            targets.append(target);
+    };
+
+    // The start of the script is enough, wrappers are short.
+    const QList<QByteArray> lines = QByteArray::fromRawData(reinterpret_cast<const char *>(data),
+                                                            int(qMin<qint64>(size, 64 * 1024))).split('\n');
+
+    for (int i = 0; i < lines.size(); ++i) {
+        const QStringList words = QString::fromLocal8Bit(lines.at(i)).simplified().split(QLatin1Char(' '));
+
+        if (i == 0 && words.first().startsWith(QLatin1String("#!"))) {
+            const QString interpreter = words.first().mid(2);
+            // "#!/usr/bin/env python3" runs python3.
+            if (interpreter.endsWith(QLatin1String("/env")) && words.size() > 1)
+                resolve(words.at(1));
+            else
+                resolve(interpreter);
+            continue;
+        }
+
+        if (words.first() != QLatin1String("exec"))
+            continue;
+
+        for (int j = 1; j < words.size(); ++j) {
+            if (!words.at(j).startsWith(QLatin1Char('-'))) {
+                resolve(words.at(j));
+                break;
+            }
+        }
+    }
+
+    for (const QString &suffix : { QStringLiteral(".bin"), QStringLiteral("-bin") }) {
+        const QString companion = directory.filePath(info.fileName() + suffix);
+        if (!targets.contains(companion) && QFileInfo(companion).isFile())
+            targets.append(companion);
+    }
+
+    return targets;
+}
+
+static QStringList systemLibraryPaths()
+{
+    QStringList paths;
+
+    // ld.so.conf lists the multiarch directories of the distribution.
+    QStringList confFiles { QStringLiteral("/etc/ld.so.conf") };
+    QDirIterator it("/etc/ld.so.conf.d", { "*.conf" }, QDir::Files);
+    while (it.hasNext())
+        confFiles.append(it.next());
+
+    for (const QString &confFile : confFiles) {
+        QFile file(confFile);
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+
+        while (!file.atEnd()) {
+            const QString line = QString::fromLocal8Bit(file.readLine()).trimmed();
+            if (line.startsWith('/') && !paths.contains(line))
+                paths.append(line);
+        }
+    }
+
+    paths << "/lib" << "/usr/lib" << "/lib64" << "/usr/lib64";
+
+    return paths;
+}
+
+Prewarmer *Prewarmer::self()
+{
+    static Prewarmer *s_self = new Prewarmer;
+    return s_self;
+}
+
+Prewarmer::Prewarmer(QObject *parent)
+    : QObject(parent)
+{
+    QSettings settings("cutefishos", "launcher");
+    m_enabled = settings.value("PrewarmLaunch", true).toBool();
+
+    m_pool.setMaxThreadCount(1);
+}
+
+bool Prewarmer::isEnabled() const
+{
+    return m_enabled;
+}
+
+void Prewarmer::prewarm(const QString &program)
+{
+    if (!m_enabled || program.isEmpty())
+        return;
+
+    const QString fileName = ExecutableResolver::self()->find(program);
+
+    if (fileName.isEmpty())
+        return;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - m_recent.value(fileName, -RecentInterval) < RecentInterval)
+        return;
+
+    m_recent.insert(fileName, now);
+
+    QtConcurrent::run(&m_pool, Prewarmer::warm, fileName);
+}
+
+void Prewarmer::warm(const QString &fileName)
+{
+    warmFile(fileName, true);
+}
+
+void Prewarmer::warmFile(const QString &fileName, bool followScripts)
+{
+    static const QStringList systemPaths = systemLibraryPaths();
+
+    const QString realFileName = QFileInfo(fileName).canonicalFilePath();
+    QFile file(realFileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    ::posix_fadvise(file.handle(), 0, 0, POSIX_FADV_WILLNEED);
+
+    const qint64 size = file.size();
+    const uchar *data = file.map(0, size);
+
+    if (!data)
+        return;
+
+    // Wrapper scripts (e.g. libreoffice) are followed one level, to the
+    // binary that does the actual work.
+    if (size >= 2 && data[0] == '#' && data[1] == '!') {
+        const QStringList targets = followScripts ? scriptTargets(data, size, realFileName) : QStringList();
+        file.unmap(const_cast<uchar *>(data));
+
+        for (const QString &target : targets)
+            warmFile(target, false);
+        return;
+    }
+
+    if (size < EI_NIDENT || memcmp(data, ELFMAG, SELFMAG) != 0)
+        return;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    if (data[EI_DATA] != ELFDATA2LSB)
+        return;
+#else
+    if (data[EI_DATA] != ELFDATA2MSB)
+        return;
+#endif
+
+    QStringList needed;
+    QStringList runPath;
+
+    if (data[EI_CLASS] == ELFCLASS64)
+        readDynamic<Elf64_Ehdr, Elf64_Phdr, Elf64_Dyn>(data, size, &needed, &runPath);
+    else if (data[EI_CLASS] == ELFCLASS32)
+        readDynamic<Elf32_Ehdr, Elf32_Phdr, Elf32_Dyn>(data, size, &needed, &runPath);
+
+    file.unmap(const_cast<uchar *>(data));
+
+    const QString origin = QFileInfo(realFileName).absolutePath();
+    QStringList searchPaths;
+
+    for (QString path : runPath) {
+        path.replace(QLatin1String("${ORIGIN}"), origin);
+        path.replace(QLatin1String("$ORIGIN"), origin);
+        searchPaths.append(path);
+    }
+
+    for (const QString &path : QString::fromLocal8Bit(qgetenv("LD_LIBRARY_PATH")).split(':')) {
+        if (!path.isEmpty())
+            searchPaths.append(path);
+    }
+
+    searchPaths += systemPaths;
+
+    for (const QString &library : needed) {
+        if (library.contains('/')) {
+            adviseWillNeed(library);
+            continue;
+        }
+
+        for (const QString &path : searchPaths) {
+            const QString candidate = path + '/' + library;
+            if (QFile::exists(candidate)) {
+                adviseWillNeed(candidate);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PREWARMER_H
+#define PREWARMER_H
+
+#include <QObject>
+#include <QHash>
+#include <QThreadPool>
+
+/**
+ * Pulls an application into the page cache before it is launched.
+ *
+ * Between pressing an icon and releasing it there is enough time to have
+ * the kernel read the executable and the libraries it directly links
+ * (DT_NEEDED) in the background, so exec() finds them in memory. Wrapper
+ * scripts are followed one level, to what they exec.
+ * Controlled by the PrewarmLaunch key of the "cutefishos/launcher" config.
+ */
+class Prewarmer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static Prewarmer *self();
+
+    bool isEnabled() const;
+
+    // Returns immediately, the work happens on a background thread.
+    void prewarm(const QString &program);
+
+private:
+    explicit Prewarmer(QObject *parent = nullptr);
+
+    static void warm(const QString &fileName);
+    static void warmFile(const QString &fileName, bool followScripts);
+
+private:
+    QThreadPool m_pool;
+    QHash<QString, qint64> m_recent;
+    bool m_enabled;
+};
+
+#endif // PREWARMER_H
@@ -18,9 +18,24 @@
  */
 
 #include "processprovider.h"
-#include <QDBusInterface>
-#include <QDBusPendingCall>
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
 #include <QProcess>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(LAUNCHER_PROCESS, "cutefish.launcher.process")
+
+// Long enough for a busy session daemon, short enough that a hung one
+// doesn't hold the click forever. A reply arriving later is ignored.
+static const int LaunchTimeout = 3000;
+
+ProcessProvider *ProcessProvider::self()
+{
+    static ProcessProvider *s_self = new ProcessProvider;
+    return s_self;
+}
 
 ProcessProvider::ProcessProvider(QObject *parent)
     : QObject(parent)
@@ -28,19 +43,47 @@ ProcessProvider::ProcessProvider(QObject *parent)
 
 }
 
+void ProcessProvider::launch(const QString &exec, const QStringList &args)
+{
+    // A plain message avoids the introspection QDBusInterface does.
+    QDBusMessage message = QDBusMessage::createMethodCall("com.cutefish.Session",
+                                                          "/Session",
+                                                          "com.cutefish.Session",
+                                                          "launch");
+    message.setArguments(QList<QVariant>() << exec << args);
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message, LaunchTimeout), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [=] (QDBusPendingCallWatcher *call) {
+        if (call->isError()) {
+            // Only start it ourselves if the daemon cannot have started it.
+            // After a timeout it may still be on its way.
+            switch (call->error().type()) {
+            case QDBusError::ServiceUnknown:
+            case QDBusError::NameHasNoOwner:
+            case QDBusError::UnknownMethod:
+                startLocally(exec, args);
+                break;
+            default:
+                qCWarning(LAUNCHER_PROCESS) << "Session launch failed" << exec << call->error().message();
+                emit launched(exec, false, true);
+                break;
+            }
+        } else {
+            emit launched(exec, true, true);
+        }
+
+        call->deleteLater();
+    });
+}
+
 bool ProcessProvider::startDetached(const QString &exec, QStringList args)
 {
-    QDBusInterface iface("com.cutefish.Session",
-                         "/Session",
-                         "com.cutefish.Session", QDBusConnection::sessionBus());
-
-    if (iface.isValid()) {
-        iface.asyncCall("launch", exec, args).waitForFinished();
-        return true;
-    } else {
-        QProcess process;
-        process.startDetached(exec, args);
-    }
-
-    return false;
+    ProcessProvider::self()->launch(exec, args);
+    return true;
+}
+
+void ProcessProvider::startLocally(const QString &exec, const QStringList &args)
+{
+    const bool success = QProcess::startDetached(exec, args);
+    emit launched(exec, success, false);
 }
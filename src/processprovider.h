@@ -21,15 +21,37 @@
 #define PROCESSPROVIDER_H
 
 #include <QObject>
+#include <QStringList>
 
+/**
+ * Starts applications through the session daemon without blocking.
+ *
+ * launch() returns immediately, the reply of com.cutefish.Session is
+ * handled by a pending-call watcher. If the session daemon is missing or
+ * has no launch method, the process is started locally instead. Other
+ * errors, a timeout included, are reported as a failed launch since the
+ * daemon may still be starting it. Either way launched() reports the
+ * outcome.
+ */
 class ProcessProvider : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit ProcessProvider(QObject *parent = nullptr);
+    static ProcessProvider *self();
+
+    void launch(const QString &exec, const QStringList &args = QStringList());
 
+    // Kept for existing callers, always returns true as the launch is queued.
     Q_INVOKABLE static bool startDetached(const QString &exec, QStringList args = QStringList());
+
+signals:
+    void launched(const QString &exec, bool success, bool viaSession);
+
+private:
+    explicit ProcessProvider(QObject *parent = nullptr);
+
+    void startLocally(const QString &exec, const QStringList &args);
 };
 
 #endif // PROCESSPROVIDER_H
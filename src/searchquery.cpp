@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "searchquery.h"
+
+static bool containsText(const AppItem &item, const QString &text)
+{
+    return item.name.contains(text, Qt::CaseInsensitive) ||
+           item.id.contains(text, Qt::CaseInsensitive);
+}
+
+SearchQuery SearchQuery::parse(const QString &query)
+{
+    SearchQuery result;
+    QStringList words;
+    bool plain = true;
+
+    const QStringList tokens = query.split(QLatin1Char(' '));
+
+    for (const QString &token : tokens) {
+        if (token.isEmpty())
+            continue;
+
+        const bool excluded = token.size() > 1 && token.at(0) == QLatin1Char('-');
+        const QString term = excluded ? token.mid(1) : token;
+
+        if (term.startsWith(QLatin1String("cat:"), Qt::CaseInsensitive)) {
+            // Nothing to filter by until a letter is typed.
+            const QString category = term.mid(4).toLower();
+            if (!category.isEmpty())
+                (excluded ? result.excludedCategories : result.categories).append(category);
+        } else if (term.compare(QLatin1String("new:"), Qt::CaseInsensitive) == 0) {
+            (excluded ? result.excludedFlags : result.flags) |= NewInstalled;
+        } else if (term.compare(QLatin1String("pinned:"), Qt::CaseInsensitive) == 0) {
+            (excluded ? result.excludedFlags : result.flags) |= Pinned;
+        } else if (excluded) {
+            result.excludedText.append(term);
+        } else {
+            words.append(token);
+            continue;
+        }
+
+        plain = false;
+    }
+
+    result.text = plain ? query : words.join(QLatin1Char(' '));
+    return result;
+}
+
+bool SearchQuery::matches(const AppItem &item) const
+{
+    if (!text.isEmpty() && !containsText(item, text))
+        return false;
+
+    for (const QString &word : excludedText) {
+        if (containsText(item, word))
+            return false;
+    }
+
+    return true;
+}
+
+void SearchIndex::build(const QList<AppItem> &items, const QSet<QString> &pinned)
+{
+    m_size = items.size();
+    const int words = (m_size + 63) / 64;
+
+    m_all.fill(0, words);
+    m_newInstalled.fill(0, words);
+    m_pinned.fill(0, words);
+    m_categories.clear();
+
+    for (int row = 0; row < m_size; ++row) {
+        const AppItem &item = items.at(row);
+        const int word = row / 64;
+        const quint64 bit = quint64(1) << (row % 64);
+
+        m_all[word] |= bit;
+
+        if (item.newInstalled)
+            m_newInstalled[word] |= bit;
+
+        if (pinned.contains(item.id))
+            m_pinned[word] |= bit;
+
+        for (const QString &category : item.categories) {
+            Bits &bits = m_categories[category.toLower()];
+            if (bits.isEmpty())
+                bits.fill(0, words);
+            bits[word] |= bit;
+        }
+    }
+}
+
+SearchIndex::Bits SearchIndex::filter(const SearchQuery &query) const
+{
+    Bits result = m_all;
+    quint64 *rows = result.data();
+    const int words = result.size();
+
+    auto intersect = [rows, words] (const Bits &bits) {
+        for (int i = 0; i < words; ++i)
+            rows[i] &= bits.at(i);
+    };
+
+    auto subtract = [rows, words] (const Bits &bits) {
+        for (int i = 0; i < words; ++i)
+            rows[i] &= ~bits.at(i);
+    };
+
+    if (query.flags & SearchQuery::NewInstalled)
+        intersect(m_newInstalled);
+    if (query.flags & SearchQuery::Pinned)
+        intersect(m_pinned);
+    if (query.excludedFlags & SearchQuery::NewInstalled)
+        subtract(m_newInstalled);
+    if (query.excludedFlags & SearchQuery::Pinned)
+        subtract(m_pinned);
+
+    for (const QString &category : query.categories)
+        intersect(categoryBits(category));
+    for (const QString &category : query.excludedCategories)
+        subtract(categoryBits(category));
+
+    return result;
+}
+
+SearchIndex::Bits SearchIndex::categoryBits(const QString &prefix) const
+{
+    Bits result(m_all.size(), 0);
+    quint64 *rows = result.data();
+
+    for (auto it = m_categories.constBegin(); it != m_categories.constEnd(); ++it) {
+        if (!it.key().startsWith(prefix))
+            continue;
+
+        for (int i = 0; i < result.size(); ++i)
+            rows[i] |= it.value().at(i);
+    }
+
+    return result;
+}
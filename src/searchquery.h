@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEARCHQUERY_H
+#define SEARCHQUERY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QtAlgorithms>
+
+#include "appitem.h"
+
+/**
+ * What was typed in the search box.
+ *
+ * "cat:graphics" keeps apps of a category (or of the ones it is the
+ * start of, while it is being typed), "new:" newly installed and
+ * "pinned:" pinned ones. A leading '-' turns a filter or a word into an
+ * exclusion. The other words are matched as one substring, a query
+ * without any of the above is matched as typed.
+ */
+class SearchQuery
+{
+public:
+    enum Flag {
+        NewInstalled = 1 << 0,
+        Pinned = 1 << 1
+    };
+
+    static SearchQuery parse(const QString &query);
+
+    bool matches(const AppItem &item) const;
+
+    QString text;
+    QStringList excludedText;
+
+    // Lower case.
+    QStringList categories;
+    QStringList excludedCategories;
+
+    int flags = 0;
+    int excludedFlags = 0;
+};
+
+/**
+ * One bitset per flag and category over the rows of a list of apps, so
+ * filters cost a word operation per 64 apps. Built again when the list
+ * changes.
+ */
+class SearchIndex
+{
+public:
+    typedef QVector<quint64> Bits;
+
+    void build(const QList<AppItem> &items, const QSet<QString> &pinned);
+
+    int size() const { return m_size; }
+
+    // Rows that pass the filters of query, its text is left to matches().
+    Bits filter(const SearchQuery &query) const;
+
+    // Calls f(row) for each set bit, in order.
+    template <typename F>
+    static void forEach(const Bits &bits, F f)
+    {
+        for (int word = 0; word < bits.size(); ++word) {
+            for (quint64 w = bits.at(word); w; w &= w - 1)
+                f(word * 64 + int(qCountTrailingZeroBits(w)));
+        }
+    }
+
+private:
+    // Union of the categories starting with prefix.
+    Bits categoryBits(const QString &prefix) const;
+
+    int m_size = 0;
+    Bits m_all;
+    Bits m_newInstalled;
+    Bits m_pinned;
+    QHash<QString, Bits> m_categories;
+};
+
+#endif // SEARCHQUERY_H
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QAtomicInteger>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QMutex>
+#include <QVector>
+#include <QDebug>
+
+#include <time.h>
+
+namespace Trace {
+
+struct Event {
+    const char *name;
+    qint64 begin;
+    qint64 end;
+};
+
+// 8192 events of 24 bytes per recording thread.
+static const int Capacity = 8192;
+
+struct Buffer {
+    Event events[Capacity];
+    QAtomicInteger<quint64> count;
+    int tid;
+    QString threadName;
+};
+
+static QAtomicInt s_enabled(0);
+static QMutex s_buffersMutex;
+static QVector<Buffer *> s_buffers;
+static QVector<Buffer *> s_freeBuffers;
+static int s_lastTid = 0;
+
+// The buffer of a finished thread keeps its events for dump() until
+// another thread starts recording and takes it over, so pool threads
+// coming and going don't add up.
+struct LocalBuffer {
+    Buffer *buffer = nullptr;
+
+    ~LocalBuffer()
+    {
+        if (!buffer)
+            return;
+
+        QMutexLocker locker(&s_buffersMutex);
+        s_freeBuffers.append(buffer);
+    }
+};
+
+static thread_local LocalBuffer t_buffer;
+
+static Buffer *localBuffer()
+{
+    if (t_buffer.buffer)
+        return t_buffer.buffer;
+
+    QThread *thread = QThread::currentThread();
+    QString threadName = thread->objectName();
+    if (threadName.isEmpty() && QCoreApplication::instance()
+            && thread == QCoreApplication::instance()->thread())
+        threadName = QStringLiteral("main");
+
+    // Under the lock, dump() never sees a buffer being taken over.
+    QMutexLocker locker(&s_buffersMutex);
+
+    Buffer *buffer;
+    if (!s_freeBuffers.isEmpty()) {
+        buffer = s_freeBuffers.takeLast();
+    } else {
+        buffer = new Buffer;
+        s_buffers.append(buffer);
+    }
+
+    buffer->count.storeRelease(0);
+    buffer->tid = ++s_lastTid;
+    buffer->threadName = threadName;
+
+    t_buffer.buffer = buffer;
+    return buffer;
+}
+
+static QByteArray jsonString(const QString &string)
+{
+    QString escaped;
+    escaped.reserve(string.size());
+
+    for (const QChar c : string) {
+        if (c == QLatin1Char('"') || c == QLatin1Char('\\')) {
+            escaped += QLatin1Char('\\');
+            escaped += c;
+        } else if (c.unicode() < 0x20) {
+            escaped += QStringLiteral("\\u%1").arg(c.unicode(), 4, 16, QLatin1Char('0'));
+        } else {
+            escaped += c;
+        }
+    }
+
+    return '"' + escaped.toUtf8() + '"';
+}
+
+bool isEnabled()
+{
+    return s_enabled.loadAcquire();
+}
+
+void setEnabled(bool enabled)
+{
+    s_enabled.storeRelease(enabled);
+}
+
+qint64 now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void record(const char *name, qint64 begin, qint64 end)
+{
+    Buffer *buffer = localBuffer();
+    const quint64 count = buffer->count.loadAcquire();
+
+    Event &event = buffer->events[count % Capacity];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+
+    buffer->count.storeRelease(count + 1);
+}
+
+bool dump(const QString &fileName)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    auto separator = [&] {
+        if (!first)
+            json += ",\n";
+        first = false;
+    };
+
+    QMutexLocker locker(&s_buffersMutex);
+
+    for (const Buffer *buffer : qAsConst(s_buffers)) {
+        if (!buffer->threadName.isEmpty()) {
+            separator();
+            json += QStringLiteral("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%1,\"tid\":%2,\"args\":{\"name\":")
+                    .arg(pid).arg(buffer->tid).toUtf8();
+            json += jsonString(buffer->threadName) + "}}";
+        }
+
+        // Events are copied while their thread may still be recording, the
+        // oldest few can be overwritten meanwhile. Good enough for a trace.
+        const quint64 count = buffer->count.loadAcquire();
+        const quint64 start = count > quint64(Capacity) ? count - Capacity : 0;
+
+        for (quint64 i = start; i < count; ++i) {
+            const Event event = buffer->events[i % Capacity];
+
+            separator();
+            json += "{\"name\":" + jsonString(QLatin1String(event.name));
+            json += QStringLiteral(",\"ph\":\"X\",\"pid\":%1,\"tid\":%2,\"ts\":%3,\"dur\":%4}")
+                    .arg(pid).arg(buffer->tid)
+                    .arg(event.begin / 1000.0, 0, 'f', 3)
+                    .arg((event.end - event.begin) / 1000.0, 0, 'f', 3).toUtf8();
+        }
+    }
+
+    json += "]}\n";
+
+    file.write(json);
+    return file.commit();
+}
+
+QString dumpPath(const QString &name)
+{
+    if (name.isEmpty() || name.contains(QLatin1Char('/')) || name.startsWith(QLatin1Char('.')))
+        return QString();
+
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (directory.isEmpty())
+        return QString();
+
+    return QStringLiteral("%1/cutefish-launcher-trace-%2.json").arg(directory, name);
+}
+
+void initialize()
+{
+    const QString value = QString::fromLocal8Bit(qgetenv("CUTEFISH_LAUNCHER_TRACE"));
+
+    if (value.isEmpty() || value == QLatin1String("0"))
+        return;
+
+    setEnabled(true);
+
+    if (value != QLatin1String("1")) {
+        QObject::connect(qApp, &QCoreApplication::aboutToQuit, [value] {
+            if (!dump(value))
+                qWarning() << "Failed to write trace to" << value;
+        });
+    }
+}
+
+}
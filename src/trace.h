@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2021 CutefishOS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * Hot-path tracing.
+ *
+ * Spans are recorded into a fixed ring buffer owned by the recording
+ * thread, so recording takes no lock; while tracing is off a span costs
+ * one atomic load. dump() writes everything still in the buffers
+ * as Chrome trace-event JSON (chrome://tracing, Perfetto).
+ *
+ * Enable with CUTEFISH_LAUNCHER_TRACE=1, or set it to a file name to also
+ * dump there on exit. At runtime use the SetTracing and DumpTrace calls
+ * of com.cutefish.Launcher, the latter only writes to dumpPath(). Names
+ * must be string literals.
+ */
+namespace Trace {
+
+bool isEnabled();
+void setEnabled(bool enabled);
+
+// Monotonic time in nanoseconds.
+qint64 now();
+
+void record(const char *name, qint64 begin, qint64 end);
+
+bool dump(const QString &fileName);
+
+// $XDG_RUNTIME_DIR/cutefish-launcher-trace-<name>.json, or an empty
+// string if name is not a plain base name.
+QString dumpPath(const QString &name);
+
+// Reads CUTEFISH_LAUNCHER_TRACE, call once the application object exists.
+void initialize();
+
+class Span
+{
+public:
+    explicit Span(const char *name)
+        : m_name(isEnabled() ? name : nullptr)
+        , m_begin(m_name ? now() : 0)
+    {
+    }
+
+    ~Span()
+    {
+        if (m_name)
+            record(m_name, m_begin, now());
+    }
+
+private:
+    Q_DISABLE_COPY(Span)
+
+    const char *m_name;
+    qint64 m_begin;
+};
+
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name) Trace::Span TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#endif // TRACE_H